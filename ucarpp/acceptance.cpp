@@ -0,0 +1,94 @@
+//
+//  acceptance.cpp
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#include "acceptance.h"
+
+using namespace std;
+using namespace solver;
+
+
+/*** Acceptance ***/
+
+/**
+ * Costruttore.
+ *
+ * @param criterion		il criterio da usare
+ * @param parameters	i parametri della ricerca ( TEMPERATURE, COOLING, DEVIATION, LAHC_LENGTH )
+ * @param profit		il profitto della soluzione di partenza
+ * @param upperBound	il limite superiore al profitto, a cui tende il livello del diluvio
+ * @param nIter			il numero di iterazioni previste
+ */
+Acceptance::Acceptance( AcceptanceCriterion criterion, const Parameters& parameters, uint profit, uint upperBound, int nIter ):
+	criterion( criterion ), cooling( parameters.cooling ), deviation( parameters.deviation ),
+	history( parameters.lahcLength, profit ), iteration( 0 )
+{
+	// Se non indicata, la temperatura iniziale accetta con probabilità 1/2 un peggioramento di DEVIATION
+	temperature = parameters.temperature;
+	if ( temperature <= 0 )
+		temperature = deviation * profit / log( 2 ) + 1;
+
+	threshold = deviation * profit;
+
+	// Il livello parte sotto la soluzione iniziale e raggiunge il limite superiore all'ultima iterazione
+	level = ( 1 - deviation ) * profit;
+	rain = ( upperBound > level ? ( upperBound - level ) / max( nIter, 1 ) : 0 );
+}
+
+/**
+ * Decide se spostarsi sulla soluzione candidata.
+ *
+ * @param candidate	la soluzione candidata
+ * @param current	la soluzione corrente
+ * @param best		la miglior soluzione trovata
+ * @return	vero, se la ricerca deve spostarsi sulla candidata
+ */
+bool Acceptance::accept( const Solution& candidate, const Solution& current, const Solution& best ) const
+{
+	if ( candidate > current )
+		return true;
+
+	float profit = candidate.getProfit(),
+		  delta = profit - current.getProfit();
+
+	switch ( criterion )
+	{
+		case ACCEPT_SA:
+			return (float)rand() / RAND_MAX < exp( delta / temperature );
+
+		case ACCEPT_TA:
+			return -delta <= threshold;
+
+		case ACCEPT_RRT:
+			return profit >= ( 1 - deviation ) * best.getProfit();
+
+		case ACCEPT_LAHC:
+			return profit >= history[ iteration % history.size() ];
+
+		case ACCEPT_GD:
+			return profit >= level;
+
+		case ACCEPT_STRICT:
+		default:
+			return false;
+	}
+}
+
+/**
+ * Fa avanzare il criterio di un'iterazione, dopo la decisione.
+ *
+ * @param current	la soluzione corrente dopo la decisione
+ */
+void Acceptance::update( const Solution& current )
+{
+	temperature *= cooling;
+	threshold *= cooling;
+	level += rain;
+
+	history[ iteration % history.size() ] = current.getProfit();
+	iteration++;
+}
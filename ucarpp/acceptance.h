@@ -0,0 +1,54 @@
+//
+//  acceptance.h
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#ifndef __ucarpp__acceptance__
+#define __ucarpp__acceptance__
+
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+#include "headings.h"
+#include "parameters.h"
+#include "solution.h"
+
+namespace solver
+{
+	/**
+	 * Criterio di accettazione del passo "Move or not" delle ricerche.
+	 * Una soluzione migliore della corrente è sempre accettata; le altre a seconda del criterio:
+	 *	STRICT	mai ( comportamento storico di VNS e VND )
+	 *	SA		simulated annealing, con probabilità exp( delta / T ) e T che decresce di COOLING
+	 *	TA		threshold accepting, se il peggioramento non supera una soglia che decresce di COOLING
+	 *	RRT		record to record travel, se il profitto dista meno di DEVIATION dal record
+	 *	LAHC	late acceptance, se non peggiora la corrente di LAHC_LENGTH iterazioni prima
+	 *	GD		great deluge, se supera un livello che sale verso il limite superiore
+	 */
+	class Acceptance
+	{
+		private:
+			AcceptanceCriterion criterion;
+			float cooling;
+			float deviation;
+
+			float temperature;
+			float threshold;
+			float level;
+			float rain;
+			std::vector<uint> history;
+			int iteration;
+
+		public:
+			Acceptance( AcceptanceCriterion, const Parameters&, uint, uint, int );
+
+			bool accept( const Solution&, const Solution&, const Solution& ) const;
+			void update( const Solution& );
+	};
+}
+
+#endif /* defined(__ucarpp__acceptance__) */
@@ -0,0 +1,155 @@
+//
+//  bound.cpp
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#include "bound.h"
+
+using namespace std;
+using namespace solver;
+using namespace model;
+
+
+/*** Bound ***/
+
+/**
+ * Costruttore.
+ * Seleziona i lati profittevoli che un veicolo può servire rientrando al deposito entro tMax
+ * e calcola il limite superiore per l'intera flotta.
+ *
+ * @param graph	il grafo, con la magliatura già completata
+ * @param depot	il deposito
+ * @param M		il numero di veicoli
+ * @param Q		la capacità di ogni veicolo
+ * @param tMax	il tempo a disposizione di ogni veicolo
+ */
+Bound::Bound( const Graph& graph, uint depot, uint M, uint Q, uint tMax )
+{
+	for ( Edge* edge : graph.getEdges() )
+	{
+		if ( edge->getProfit() <= 0 || edge->getDemand() > Q )
+			continue;
+
+		// Raggiungibilità: andata, servizio e ritorno devono stare in tMax
+		if ( graph.getDistance( depot, edge->getSrc() ) + edge->getCost() +
+			 graph.getDistance( edge->getDst(), depot ) > tMax )
+			continue;
+
+		edges.push_back( edge );
+	}
+
+	// I profitti sono interi: tollero l'errore di arrotondamento prima di troncare
+	upperBound = getUpperBound( vector<bool>( edges.size(), true ), M * Q, M * tMax ) + 1e-3;
+}
+
+/**
+ * Getter del limite superiore al profitto dell'intera flotta.
+ *
+ * @return	il limite superiore calcolato alla costruzione
+ */
+uint Bound::getUpperBound() const
+{
+	return upperBound;
+}
+
+/**
+ * Limite superiore al profitto ottenibile da un sottoinsieme dei lati raggiungibili,
+ * date le risorse residue.
+ * Per ogni lambda in [0, 1] ogni soluzione ammissibile rispetta il vincolo surrogato
+ *	lambda * D / capacity + ( 1 - lambda ) * C / time <= 1,
+ * per cui lo zaino frazionario su tale vincolo è un limite valido: si tiene il minimo.
+ *
+ * @param available	indica, per ogni lato di getEdges(), se è ancora disponibile
+ * @param capacity	la capacità residua complessiva
+ * @param time		il tempo residuo complessivo
+ * @return	il limite superiore al profitto ottenibile
+ */
+float Bound::getUpperBound( const vector<bool>& available, float capacity, float time ) const
+{
+	// Elimino i lati che da soli non rientrano nelle risorse residue
+	vector<Edge*> items;
+	float free = 0;
+	for ( int i = 0; i < edges.size(); i++ )
+	{
+		if ( !available[ i ] || edges[ i ]->getDemand() > capacity || edges[ i ]->getCost() > time )
+			continue;
+
+		if ( edges[ i ]->getDemand() == 0 && edges[ i ]->getCost() == 0 )
+			free += edges[ i ]->getProfit();
+		else
+			items.push_back( edges[ i ] );
+	}
+
+	float best = -1;
+	vector< pair<float, Edge*> > ratios( items.size() );
+	for ( int l = 0; l <= LAMBDA_STEPS; l++ )
+	{
+		float lambda = (float)l / LAMBDA_STEPS;
+
+		// Con una risorsa esaurita il vincolo corrispondente non può essere normalizzato
+		if ( ( lambda > 0 && capacity <= 0 ) || ( lambda < 1 && time <= 0 ) )
+			continue;
+
+		for ( int i = 0; i < items.size(); i++ )
+		{
+			float weight = ( lambda > 0 ? lambda * items[ i ]->getDemand() / capacity : 0 ) +
+						   ( lambda < 1 ? ( 1 - lambda ) * items[ i ]->getCost() / time : 0 );
+			ratios[ i ] = make_pair( weight, items[ i ] );
+		}
+
+		// Ordino per profitto su peso decrescente ( i pesi nulli per primi )
+		sort( ratios.begin(), ratios.end(),
+			  []( const pair<float, Edge*>& lhs, const pair<float, Edge*>& rhs )
+			  {
+				  return lhs.second->getProfit() * rhs.first > rhs.second->getProfit() * lhs.first;
+			  } );
+
+		float profit = 0,
+			  residual = 1;
+		for ( auto item : ratios )
+		{
+			if ( item.first <= residual )
+			{
+				profit += item.second->getProfit();
+				residual -= item.first;
+			}
+			else
+			{
+				profit += item.second->getProfit() * residual / item.first;
+				break;
+			}
+		}
+
+		if ( best < 0 || profit < best )
+			best = profit;
+	}
+
+	// Nessun vincolo normalizzabile: restano solo i lati gratuiti
+	if ( best < 0 )
+		best = 0;
+
+	return free + best;
+}
+
+/**
+ * Calcola la distanza relativa di un profitto dal limite superiore.
+ *
+ * @param profit	il profitto della soluzione corrente
+ * @return	( bound - profit ) / bound, 0 se il limite è nullo
+ */
+float Bound::getGap( uint profit ) const
+{
+	if ( upperBound == 0 || profit >= upperBound )
+		return 0;
+
+	return (float)( upperBound - profit ) / upperBound;
+}
+
+// Getter dei lati raggiungibili
+const vector<Edge*>& Bound::getEdges() const
+{
+	return edges;
+}
@@ -0,0 +1,48 @@
+//
+//  bound.h
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#ifndef __ucarpp__bound__
+#define __ucarpp__bound__
+
+#include <vector>
+#include <algorithm>
+
+#include "headings.h"
+#include "edge.h"
+#include "graph.h"
+
+namespace solver
+{
+	/**
+	 * Limite superiore al profitto ottenibile.
+	 * Considera solo i lati profittevoli raggiungibili dal deposito entro tMax e con domanda
+	 * non superiore a Q, e risolve in modo frazionario lo zaino surrogato ottenuto combinando
+	 * con un peso lambda i vincoli di capacità e di tempo dell'intera flotta.
+	 */
+	class Bound
+	{
+		private:
+			// Numero di pesi con cui combinare i due vincoli nel rilassamento surrogato
+			static const int LAMBDA_STEPS = 20;
+
+			// Lati raggiungibili, ordinati per indice
+			std::vector<model::Edge*> edges;
+			uint upperBound;
+
+		public:
+			Bound( const model::Graph&, uint, uint, uint, uint );
+
+			uint getUpperBound() const;
+			float getUpperBound( const std::vector<bool>&, float, float ) const;
+			float getGap( uint ) const;
+
+			const std::vector<model::Edge*>& getEdges() const;
+	};
+}
+
+#endif /* defined(__ucarpp__bound__) */
@@ -22,7 +22,8 @@ using namespace model;
  */
 Edge::Edge( uint src, uint dst ):
 	src( src < dst ? src : dst ),
-	dst( src > dst ? src : dst ) {}
+	dst( src > dst ? src : dst ),
+	id( 0 ) {}
 
 
 /**
@@ -61,6 +62,27 @@ uint Edge::getDst( uint src ) const
 	return src == this->dst ? this->src : this->dst;
 }
 
+/**
+ * Getter dell'indice del lato nel grafo.
+ * I lati profittevoli hanno indici da 0 a L - 1, quelli aggiunti da completeCosts i successivi.
+ *
+ * @return	l'indice del lato.
+ */
+uint Edge::getId() const
+{
+	return id;
+}
+
+/**
+ * Setter dell'indice del lato, usato dal grafo al momento dell'inserimento.
+ *
+ * @param id	l'indice da associare al lato.
+ */
+void Edge::setId( uint id )
+{
+	this->id = id;
+}
+
 /**
  * Getter per il costo associato all'arco.
  *
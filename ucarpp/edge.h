@@ -19,6 +19,8 @@ namespace model
 	private:
 		uint src,
 			 dst;
+		// Indice del lato nel grafo
+		uint id;
 		
 		bool equals( const Edge& ) const;
 		
@@ -32,6 +34,9 @@ namespace model
 		uint getDst() const;
 		uint getDst( uint ) const;
 		
+		uint getId() const;
+		void setId( uint );
+		
 		uint getCost() const;
 		virtual uint getDemand() const = 0;
 		virtual float getProfit() const = 0;
@@ -0,0 +1,110 @@
+//
+//  elite.cpp
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#include "elite.h"
+
+using namespace std;
+using namespace solver;
+
+
+/*** ElitePool ***/
+
+/**
+ * Costruttore.
+ *
+ * @param capacity	il numero massimo di soluzioni, 0 per non tenerne
+ */
+ElitePool::ElitePool( uint capacity ):
+	capacity( capacity ) {}
+
+ElitePool::~ElitePool()
+{
+	for ( Elite& anElite : elite )
+		delete anElite.solution;
+}
+
+/**
+ * Propone una soluzione al pool.
+ * Finché c'è posto ogni soluzione nuova viene tenuta; poi una soluzione entra solo se è migliore
+ * della peggiore, e prende il posto della più simile tra quelle peggiori di lei.
+ * Una soluzione che serve gli stessi lati di una già presente la sostituisce solo se è migliore.
+ *
+ * @param solution	la soluzione proposta
+ * @return	vero, se la soluzione è entrata nel pool
+ */
+bool ElitePool::offer( const Solution& solution )
+{
+	if ( !capacity )
+		return false;
+
+	boost::dynamic_bitset<> served = solution.getServed();
+
+	int victim = -1;
+	uint closest = 0;
+	for ( int i = 0; i < elite.size(); i++ )
+	{
+		uint distance = ( served ^ elite[ i ].served ).count();
+
+		// Stessi lati serviti: tengo la migliore delle due
+		if ( !distance )
+		{
+			if ( !( solution > *elite[ i ].solution ) )
+				return false;
+
+			victim = i;
+			closest = 0;
+			break;
+		}
+
+		if ( solution > *elite[ i ].solution && ( victim < 0 || distance < closest ) )
+		{
+			victim = i;
+			closest = distance;
+		}
+	}
+
+	if ( ( victim < 0 || closest > 0 ) && elite.size() < capacity )
+	{
+		elite.push_back( { new Solution( solution ), served } );
+		return true;
+	}
+
+	if ( victim < 0 )
+		return false;
+
+	delete elite[ victim ].solution;
+	elite[ victim ].solution = new Solution( solution );
+	elite[ victim ].served = served;
+
+	return true;
+}
+
+unsigned long ElitePool::size() const
+{
+	return elite.size();
+}
+
+// Getter della i-esima soluzione del pool
+const Solution& ElitePool::getSolution( uint i ) const
+{
+	return *elite[ i ].solution;
+}
+
+// Getter dei lati serviti dalla i-esima soluzione del pool
+const boost::dynamic_bitset<>& ElitePool::getServed( uint i ) const
+{
+	return elite[ i ].served;
+}
+
+/**
+ * @return	il numero di lati serviti da una sola delle due soluzioni
+ */
+uint ElitePool::getDistance( uint i, uint j ) const
+{
+	return ( elite[ i ].served ^ elite[ j ].served ).count();
+}
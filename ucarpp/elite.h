@@ -0,0 +1,54 @@
+//
+//  elite.h
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#ifndef __ucarpp__elite__
+#define __ucarpp__elite__
+
+#include <vector>
+#include <boost/dynamic_bitset.hpp>
+
+#include "headings.h"
+#include "solution.h"
+
+namespace solver
+{
+	/**
+	 * Insieme limitato di soluzioni buone e diverse tra loro.
+	 * Ogni soluzione è rappresentata dall'insieme dei lati profittevoli serviti ( indicizzati con
+	 * Edge::getId ), e la distanza tra due soluzioni è la cardinalità della differenza simmetrica.
+	 */
+	class ElitePool
+	{
+		private:
+			struct Elite
+			{
+				Solution* solution;
+				boost::dynamic_bitset<> served;
+			};
+
+			uint capacity;
+			std::vector<Elite> elite;
+
+		public:
+			ElitePool( uint );
+			~ElitePool();
+
+			// Il pool possiede le sue soluzioni: una copia le condividerebbe
+			ElitePool( const ElitePool& ) = delete;
+			ElitePool& operator=( const ElitePool& ) = delete;
+
+			bool offer( const Solution& );
+
+			unsigned long size() const;
+			const Solution& getSolution( uint ) const;
+			const boost::dynamic_bitset<>& getServed( uint ) const;
+			uint getDistance( uint, uint ) const;
+	};
+}
+
+#endif /* defined(__ucarpp__elite__) */
@@ -0,0 +1,379 @@
+//
+//  exact.cpp
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#include "exact.h"
+
+using namespace std;
+using namespace solver;
+using namespace model;
+
+
+/*** Exact ***/
+
+/**
+ * Costruttore.
+ *
+ * @param graph		il grafo, con la magliatura già completata
+ * @param bound		il limite superiore costruito sullo stesso grafo
+ * @param depot		il deposito
+ * @param M			il numero di veicoli
+ * @param Q			la capacità di ogni veicolo
+ * @param tMax		il tempo a disposizione di ogni veicolo
+ * @param maxNodes	il numero massimo di nodi da espandere, 0 per nessun limite
+ * @param threads	il numero di thread, 0 per usarne uno per core
+ */
+Exact::Exact( const Graph& graph, const Bound& bound, uint depot, uint M, uint Q, uint tMax, long maxNodes, int threads ):
+	graph( graph ), bound( bound ), depot( depot ), M( M ), Q( Q ), tMax( tMax ), maxNodes( maxNodes ),
+	threads( threads > 0 ? threads : max( 1, (int)thread::hardware_concurrency() ) ),
+	queues( this->threads ), locks( this->threads )
+{
+	for ( Edge* edge : graph.getEdges() )
+		if ( edge->getProfit() > 0 || edge->getDemand() > 0 )
+		{
+			index[ edge ] = (int)required.size();
+			required.push_back( edge );
+		}
+
+	for ( Edge* edge : bound.getEdges() )
+		boundIndex.push_back( index.at( edge ) );
+}
+
+/**
+ * Ricava i lati serviti da un nodo: ogni lato profittevole del percorso è servito,
+ * perché un passaggio che non potrebbe servirlo per capacità non viene mai generato.
+ *
+ * @param node		il nodo
+ * @param served	dove scrivere, per ogni lato profittevole, se è servito
+ */
+void Exact::getServed( const Node& node, vector<bool>* served ) const
+{
+	served->assign( required.size(), false );
+	for ( const Step* step = node.trail.get(); step != NULL; step = step->parent.get() )
+	{
+		auto it = index.find( step->edge );
+		if ( it != index.end() )
+			(*served)[ it->second ] = true;
+	}
+}
+
+/**
+ * Percorre un lato a partire dall'ultimo nodo raggiunto.
+ * Se il lato è profittevole e nessuno lo ha ancora servito, il veicolo lo serve.
+ * Il controllo sul tempo è a carico del chiamante.
+ *
+ * @param node		il nodo da estendere
+ * @param edge		il lato da percorrere
+ * @param served	i lati serviti, aggiornati
+ * @param marked	dove annotare i lati segnati come serviti, per poterli ripristinare
+ * @return	falso, se servire il lato supera la capacità del veicolo
+ */
+bool Exact::traverse( Node& node, Edge* edge, vector<bool>* served, vector<int>* marked ) const
+{
+	auto it = index.find( edge );
+	if ( it != index.end() && !(*served)[ it->second ] )
+	{
+		if ( node.load + edge->getDemand() > Q )
+			return false;
+
+		(*served)[ it->second ] = true;
+		marked->push_back( it->second );
+		node.load += edge->getDemand();
+		node.profit += edge->getProfit();
+		node.remaining -= edge->getProfit();
+	}
+
+	node.time += edge->getCost();
+	node.last = edge->getDst( node.last );
+	node.trail = make_shared<const Step>( Step { node.vehicle, edge, node.trail } );
+
+	return true;
+}
+
+/**
+ * Riporta il veicolo corrente al deposito.
+ *
+ * @param node		il nodo da chiudere
+ * @param served	i lati serviti, aggiornati
+ * @param marked	dove annotare i lati segnati come serviti
+ * @return	falso, se il lato di ritorno non può essere percorso
+ */
+bool Exact::close( Node& node, vector<bool>* served, vector<int>* marked ) const
+{
+	if ( node.last == depot )
+		return true;
+
+	return traverse( node, graph.getEdge( node.last, depot ), served, marked );
+}
+
+/**
+ * Aggiorna la soluzione migliore se il nodo ( già chiuso ) la migliora.
+ */
+void Exact::update( const Node& node )
+{
+	// I profitti sono interi: tollero l'errore di arrotondamento
+	uint profit = node.profit + 1e-3;
+	if ( profit <= bestProfit )
+		return;
+
+	lock_guard<mutex> guard( incumbentLock );
+	if ( profit > bestProfit )
+	{
+		bestProfit = profit;
+		bestTrail = node.trail;
+	}
+}
+
+/**
+ * Espande un nodo, inserendo i figli nella coda del thread indicato.
+ *
+ * @param node		il nodo da espandere
+ * @param worker	il thread che lo espande
+ */
+void Exact::expand( Node& node, int worker )
+{
+	if ( maxNodes > 0 && ++nodes > maxNodes )
+	{
+		aborted = true;
+		return;
+	}
+	else if ( maxNodes <= 0 )
+		nodes++;
+
+	// Lati serviti dal nodo, modificati da ogni figlio e ripristinati subito dopo
+	vector<bool> served;
+	vector<int> marked;
+	getServed( node, &served );
+	auto restore = [ & ]()
+	{
+		for ( int i : marked )
+			served[ i ] = false;
+		marked.clear();
+	};
+
+	// Chiudendo subito il veicolo ( e lasciando vuoti i successivi ) ho una soluzione ammissibile
+	Node closed = node;
+	bool closable = close( closed, &served, &marked );
+	restore();
+	if ( closable )
+		update( closed );
+
+	// Limite banale: tutto il profitto residuo
+	if ( node.profit + node.remaining <= bestProfit )
+		return;
+
+	// Limite dello zaino surrogato sulle risorse residue della flotta
+	vector<bool> available( boundIndex.size() );
+	for ( int i = 0; i < boundIndex.size(); i++ )
+		available[ i ] = !served[ boundIndex[ i ] ];
+
+	uint following = M - node.vehicle - 1;
+	if ( node.profit + bound.getUpperBound( available, Q - node.load + following * Q,
+											tMax - node.time + following * tMax ) + 1e-3 <= bestProfit )
+		return;
+
+	vector<Node> children;
+	vector<float> scores;
+
+	// Passo al veicolo successivo. Un veicolo vuoto può sempre essere spostato in fondo:
+	//  lo chiudo solo se ha servito qualcosa.
+	if ( following > 0 && node.time > 0 && closable )
+	{
+		closed.vehicle++;
+		closed.time = 0;
+		closed.load = 0;
+		children.push_back( closed );
+		scores.push_back( -1 );
+	}
+
+	// Servo uno dei lati non ancora serviti, in entrambi i versi
+	for ( int i = 0; i < required.size(); i++ )
+	{
+		if ( served[ i ] || required[ i ]->getProfit() <= 0 )
+			continue;
+
+		for ( int direction = 0; direction < 2; direction++ )
+		{
+			uint u = direction ? required[ i ]->getDst() : required[ i ]->getSrc(),
+				 v = required[ i ]->getDst( u );
+
+			if ( node.time + graph.getDistance( node.last, u ) + required[ i ]->getCost() +
+				 graph.getDistance( v, depot ) > tMax )
+				continue;
+
+			Node child = node;
+			bool feasible = true;
+			if ( node.last != u )
+			{
+				Edge* deadhead = graph.getEdge( node.last, u );
+				// Il lato stesso fa da collegamento: è il caso dell'altro verso
+				feasible = deadhead != required[ i ] && traverse( child, deadhead, &served, &marked );
+			}
+
+			feasible = feasible && !served[ i ] && traverse( child, required[ i ], &served, &marked );
+			restore();
+			if ( !feasible )
+				continue;
+
+			// Ordino i figli per profitto guadagnato su tempo speso
+			children.push_back( child );
+			scores.push_back( ( child.profit - node.profit ) / ( child.time - node.time + 1 ) );
+		}
+	}
+
+	if ( children.empty() )
+		return;
+
+	// Il figlio migliore va in cima alla pila: ordino gli indici, non i nodi
+	vector<int> order( children.size() );
+	for ( int i = 0; i < order.size(); i++ )
+		order[ i ] = i;
+	sort( order.begin(), order.end(),
+		  [ & ]( int lhs, int rhs )
+		  {
+			  return scores[ lhs ] < scores[ rhs ];
+		  } );
+
+	pending += children.size();
+
+	lock_guard<mutex> guard( locks[ worker ] );
+	for ( int i : order )
+		queues[ worker ].push_back( children[ i ] );
+}
+
+/**
+ * Ruba il nodo meno profondo dalla coda di un altro thread.
+ *
+ * @param worker	il thread che cerca lavoro
+ * @param node		il nodo rubato
+ * @return	vero, se è stato trovato del lavoro
+ */
+bool Exact::steal( int worker, Node& node )
+{
+	for ( int i = 1; i < threads; i++ )
+	{
+		int victim = ( worker + i ) % threads;
+
+		lock_guard<mutex> guard( locks[ victim ] );
+		if ( !queues[ victim ].empty() )
+		{
+			node = queues[ victim ].front();
+			queues[ victim ].pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Ciclo di lavoro di un thread: espande in profondità i nodi della propria coda
+ * e, quando questa è vuota, ruba agli altri.
+ *
+ * @param worker	l'indice del thread
+ */
+void Exact::work( int worker )
+{
+	while ( !aborted )
+	{
+		Node node;
+		bool found = false;
+
+		{
+			lock_guard<mutex> guard( locks[ worker ] );
+			if ( !queues[ worker ].empty() )
+			{
+				node = queues[ worker ].back();
+				queues[ worker ].pop_back();
+				found = true;
+			}
+		}
+
+		if ( !found )
+			found = steal( worker, node );
+
+		if ( found )
+		{
+			expand( node, worker );
+			pending--;
+		}
+		else if ( pending == 0 )
+			break;
+		else
+			this_thread::yield();
+	}
+}
+
+/**
+ * Risolve il problema, partendo da una soluzione ammissibile nota.
+ *
+ * @param incumbent	la soluzione da cui prendere il limite inferiore iniziale
+ * @return	la soluzione migliore trovata, incumbent se non è stata migliorata
+ */
+Solution Exact::solve( const Solution& incumbent )
+{
+	bestProfit = incumbent.getProfit();
+	bestTrail.reset();
+	nodes = 0;
+	aborted = false;
+
+	Node root;
+	root.vehicle = 0;
+	root.last = depot;
+	root.time = 0;
+	root.load = 0;
+	root.profit = 0;
+	root.remaining = 0;
+	for ( Edge* edge : required )
+		root.remaining += edge->getProfit();
+
+	queues[ 0 ].push_back( root );
+	pending = 1;
+
+	vector<thread> workers;
+	for ( int i = 0; i < threads; i++ )
+		workers.push_back( thread( &Exact::work, this, i ) );
+	for ( auto& worker : workers )
+		worker.join();
+
+	for ( auto& queue : queues )
+		queue.clear();
+
+	if ( bestTrail == NULL )
+		return incumbent;
+
+	// Ricostruisco la soluzione: i veicoli vengono riempiti nello stesso ordine dell'albero,
+	//  per cui il primo a percorrere un lato profittevole è anche quello che lo serve.
+	vector<const Step*> path;
+	for ( const Step* step = bestTrail.get(); step != NULL; step = step->parent.get() )
+		path.push_back( step );
+
+	Solution result( M, graph );
+	for ( auto it = path.rbegin(); it != path.rend(); ++it )
+		result.addEdge( (*it)->edge, (*it)->vehicle );
+
+	return result;
+}
+
+/**
+ * @return	vero, se l'albero è stato esplorato completamente
+ */
+bool Exact::isOptimal() const
+{
+	return !aborted;
+}
+
+/**
+ * @return	il numero di nodi espansi
+ */
+long Exact::getNodes() const
+{
+	// Il nodo che supera il limite viene contato ma non espanso ( uno per thread )
+	if ( maxNodes > 0 )
+		return min( (long)nodes, maxNodes );
+	return nodes;
+}
@@ -0,0 +1,107 @@
+//
+//  exact.h
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#ifndef __ucarpp__exact__
+#define __ucarpp__exact__
+
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+#include "headings.h"
+#include "edge.h"
+#include "graph.h"
+#include "bound.h"
+#include "solution.h"
+
+namespace solver
+{
+	/**
+	 * Branch and bound sulle decisioni di servizio dei lati profittevoli.
+	 * Ogni nodo estende il percorso del veicolo corrente servendo un lato non ancora servito
+	 * ( in uno dei due versi, raggiunto col lato diretto del grafo completo ) oppure chiude il
+	 * veicolo tornando al deposito e passa al successivo.
+	 * I nodi vengono potati col Bound sulle risorse residue; l'albero viene esplorato in
+	 * profondità da più thread, ognuno con la propria coda e rubando lavoro agli altri.
+	 */
+	class Exact
+	{
+		private:
+			// Lato percorso da un veicolo. I passi formano una lista che risale verso la radice,
+			//  condivisa tra i nodi dell'albero: creare un figlio non copia il percorso.
+			struct Step
+			{
+				uint vehicle;
+				model::Edge* edge;
+				std::shared_ptr<const Step> parent;
+			};
+
+			// I lati serviti non vengono copiati: sono i lati profittevoli del percorso
+			struct Node
+			{
+				uint vehicle,
+					 last,
+					 time,
+					 load;
+				float profit,
+					  remaining;
+				std::shared_ptr<const Step> trail;
+			};
+
+			const model::Graph& graph;
+			const Bound& bound;
+			uint depot,
+				 M,
+				 Q,
+				 tMax;
+			long maxNodes;
+			int threads;
+
+			// Lati profittevoli del grafo e relativo indice
+			std::vector<model::Edge*> required;
+			std::unordered_map<const model::Edge*, int> index;
+			// Per ogni lato del Bound, il suo indice tra i lati profittevoli
+			std::vector<int> boundIndex;
+
+			// Code dei thread
+			std::vector< std::deque<Node> > queues;
+			std::vector<std::mutex> locks;
+			// Nodi creati ma non ancora espansi
+			std::atomic<long> pending;
+			std::atomic<long> nodes;
+			std::atomic<bool> aborted;
+
+			// Miglior soluzione trovata
+			std::mutex incumbentLock;
+			std::atomic<uint> bestProfit;
+			std::shared_ptr<const Step> bestTrail;
+
+			void getServed( const Node&, std::vector<bool>* ) const;
+			bool traverse( Node&, model::Edge*, std::vector<bool>*, std::vector<int>* ) const;
+			bool close( Node&, std::vector<bool>*, std::vector<int>* ) const;
+			void expand( Node&, int );
+			void update( const Node& );
+			bool steal( int, Node& );
+			void work( int );
+
+		public:
+			Exact( const model::Graph&, const Bound&, uint, uint, uint, uint, long, int );
+
+			Solution solve( const Solution& );
+
+			bool isOptimal() const;
+			long getNodes() const;
+	};
+}
+
+#endif /* defined(__ucarpp__exact__) */
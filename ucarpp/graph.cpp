@@ -34,6 +34,7 @@ Graph::Graph( int V ):
 	adjList = vector< vector<Edge*> >();
 	for ( int i = 0; i < V; i++ )
 		adjList.push_back( vector<Edge*>() );
+	matrix = vector<Edge*>( V * V, NULL );
 }
 
 /**
@@ -49,8 +50,13 @@ void Graph::addEdge( uint src, uint dst, uint cost, uint demand, float profit )
 {
 	// Creo un nuovo lato e lo aggiungo alla lista in entrambe le direzioni.
 	edges.push_back( new ProfitableEdge( src, dst, cost, demand, profit ) );
+	edges.back()->setId( (uint)edges.size() - 1 );
 	adjList[ src ].push_back( edges.back() );
 	adjList[ dst ].push_back( edges.back() );
+
+	// Tra due nodi vale il primo lato inserito
+	if ( matrix[ src * V + dst ] == NULL )
+		matrix[ src * V + dst ] = matrix[ dst * V + src ] = edges.back();
 }
 
 // Funzione per il confronto tra nodi in base al loro costo.
@@ -94,8 +100,10 @@ void Graph::completeCosts()
 				catch ( ... )
 				{
 					edges.push_back( new DijkyEdge( source, u ) );
+					edges.back()->setId( (uint)edges.size() - 1 );
 					adjList[ source ].push_back( edges.back() );
 					adjList[ u ].push_back( edges.back() );
+					matrix[ source * V + u ] = matrix[ u * V + source ] = edges.back();
 					( (DijkyEdge*)edges.back() )->setCost( INT_MAX );
 				}
 		//d[ source ] = 0;
@@ -150,6 +158,90 @@ void Graph::completeCosts()
 			//}
 		}
 	}
+
+	// Salvo le distanze in una matrice, per poterle leggere in tempo costante
+	distances = vector<uint>( V * V, 0 );
+	for ( uint u = 0; u < V; u++ )
+		for ( uint v = 0; v < V; v++ )
+			if ( u != v )
+				distances[ u * V + v ] = getEdge( u, v )->getCost();
+}
+
+/**
+ * Calcola le liste dei candidati di ogni nodo, ripartendo i nodi tra più thread.
+ * Valida solo dopo aver completato la magliatura del grafo con completeCosts.
+ *
+ * @param k			il numero di nodi più vicini da tenere, 0 per tenerli tutti
+ * @param threads	il numero di thread, 0 per usarne uno per core
+ */
+void Graph::computeCandidates( uint k, int threads )
+{
+	if ( threads <= 0 )
+		threads = max( 1, (int)thread::hardware_concurrency() );
+
+	sorted = vector< vector<uint> >( V );
+	nearest = vector< vector<uint> >( V );
+	required = vector< vector<Edge*> >( V );
+	candidates = vector< vector<Edge*> >( V );
+
+	vector<thread> workers;
+	for ( int i = 0; i < threads; i++ )
+		workers.push_back( thread( [ this, k, i, threads ]()
+								   {
+									   for ( uint u = i; u < V; u += threads )
+										   fillCandidates( u, k );
+								   } ) );
+	for ( auto& worker : workers )
+		worker.join();
+}
+
+/**
+ * Calcola le liste dei candidati di un nodo.
+ *
+ * @param u	il nodo
+ * @param k	il numero di nodi più vicini da tenere, 0 per tenerli tutti
+ */
+void Graph::fillCandidates( uint u, uint k )
+{
+	for ( uint v = 0; v < V; v++ )
+		if ( v != u )
+			sorted[ u ].push_back( v );
+
+	// A parità di distanza tengo l'ordine dei nodi, così le liste non dipendono dai thread
+	stable_sort( sorted[ u ].begin(), sorted[ u ].end(),
+				 [ this, u ]( uint lhs, uint rhs )
+				 {
+					 return getDistance( u, lhs ) < getDistance( u, rhs );
+				 } );
+
+	nearest[ u ] = sorted[ u ];
+	if ( k > 0 && k < nearest[ u ].size() )
+		nearest[ u ].resize( k );
+
+	for ( Edge* edge : adjList[ u ] )
+		if ( edge->getProfit() > 0 )
+			required[ u ].push_back( edge );
+
+	stable_sort( required[ u ].begin(), required[ u ].end(),
+				 []( const Edge* lhs, const Edge* rhs )
+				 {
+					 return lhs->getProfit() / ( lhs->getCost() + 1 ) > rhs->getProfit() / ( rhs->getCost() + 1 );
+				 } );
+
+	// Senza limite i candidati sono tutti i lati incidenti
+	if ( k == 0 || k >= V - 1 )
+	{
+		candidates[ u ] = adjList[ u ];
+		return;
+	}
+
+	candidates[ u ] = required[ u ];
+	for ( uint v : nearest[ u ] )
+	{
+		Edge* edge = getEdge( u, v );
+		if ( find( candidates[ u ].begin(), candidates[ u ].end(), edge ) == candidates[ u ].end() )
+			candidates[ u ].push_back( edge );
+	}
 }
 
 // Getter della dimensione del grafo (numero di nodi)
@@ -165,7 +257,7 @@ vector<Edge*> Graph::getAdjList( uint src ) const
 }
 
 // Getter della lista dei lati
-vector<Edge*> Graph::getEdges() const
+const vector<Edge*>& Graph::getEdges() const
 {
 	return edges;
 }
@@ -173,9 +265,84 @@ vector<Edge*> Graph::getEdges() const
 // Getter dei lati
 Edge* Graph::getEdge( uint src, uint dst ) const throw( int )
 {
-	for ( int i = 0; i < adjList[ src ].size(); i++ )
-		if ( adjList[ src ][ i ]->getDst( src ) == dst )
-			return adjList[ src ][ i ];
+	Edge* edge = matrix[ src * V + dst ];
+	if ( edge == NULL )
+		throw -1;
 	
-	throw -1;
+	return edge;
+}
+
+/**
+ * Getter della distanza minima tra due nodi.
+ * Valida solo dopo aver completato la magliatura del grafo con completeCosts.
+ *
+ * @param src	nodo sorgente
+ * @param dst	nodo destinazione
+ * @return	il costo del lato che collega src e dst, 0 se coincidono
+ */
+uint Graph::getDistance( uint src, uint dst ) const
+{
+	return distances[ src * V + dst ];
+}
+
+/**
+ * Riga della matrice delle distanze; essendo il grafo non orientato, è anche la sua colonna.
+ *
+ * @param src	nodo sorgente
+ * @return	le distanze da src verso ogni nodo, V elementi contigui
+ */
+const uint* Graph::getDistances( uint src ) const
+{
+	return &distances[ src * V ];
+}
+
+// Getter dei nodi più vicini ad un nodo, per distanza crescente
+const vector<uint>& Graph::getNearest( uint src ) const
+{
+	return nearest[ src ];
+}
+
+// Getter dei lati profittevoli incidenti ad un nodo, per rapporto profitto / costo decrescente
+const vector<Edge*>& Graph::getRequired( uint src ) const
+{
+	return required[ src ];
+}
+
+// Getter dei lati candidati uscenti da un nodo: i profittevoli incidenti ed i collegamenti ai più vicini
+const vector<Edge*>& Graph::getCandidates( uint src ) const
+{
+	return candidates[ src ];
+}
+
+/**
+ * Cerca i nodi per cui passare andando da src a dst allunga il percorso al più di slack,
+ * ovvero quelli con d( src, w ) + d( w, dst ) - d( src, dst ) <= slack.
+ * Scorro i nodi per distanza crescente da src: per la disuguaglianza triangolare
+ * la deviazione è almeno 2 ( d( src, w ) - d( src, dst ) ), per cui mi fermo appena
+ * d( src, w ) supera d( src, dst ) + slack / 2.
+ * Valida solo dopo aver calcolato i candidati con computeCandidates.
+ *
+ * @param src	nodo sorgente
+ * @param dst	nodo destinazione
+ * @param slack	l'allungamento massimo ammesso
+ * @param limit	il numero massimo di nodi da scorrere, 0 per nessun limite
+ * @return	i nodi trovati, esclusi src e dst, per distanza crescente da src
+ */
+vector<uint> Graph::getDetours( uint src, uint dst, uint slack, uint limit ) const
+{
+	vector<uint> result;
+	// Le distanze dei nodi irraggiungibili valgono INT_MAX: evito di sforare
+	unsigned long direct = getDistance( src, dst );
+
+	for ( int i = 0; i < sorted[ src ].size() && ( limit == 0 || i < limit ); i++ )
+	{
+		uint w = sorted[ src ][ i ];
+		if ( 2 * (unsigned long)getDistance( src, w ) > 2 * direct + slack )
+			break;
+
+		if ( w != dst && (unsigned long)getDistance( src, w ) + getDistance( w, dst ) <= direct + slack )
+			result.push_back( w );
+	}
+
+	return result;
 }
@@ -13,6 +13,7 @@
 #include <vector>
 #include <algorithm>
 #include <climits>
+#include <thread>
 
 #include "headings.h"
 #include "edge.h"
@@ -28,17 +29,37 @@ namespace model
 		std::vector<Edge*> edges;
 		// Lista di Adiacenza
 		std::vector< std::vector<Edge*> > adjList;
+		// Matrice dei lati diretti tra ogni coppia di nodi, per un accesso in tempo costante
+		std::vector<Edge*> matrix;
+		// Matrice delle distanze minime, riempita da completeCosts
+		std::vector<uint> distances;
+		// Liste dei candidati di ogni nodo, riempite da computeCandidates:
+		//  tutti i nodi per distanza crescente ed i primi k, i lati profittevoli incidenti
+		//  per rapporto profitto / costo ed i lati che portano agli uni ed agli altri
+		std::vector< std::vector<uint> > sorted;
+		std::vector< std::vector<uint> > nearest;
+		std::vector< std::vector<Edge*> > required;
+		std::vector< std::vector<Edge*> > candidates;
+
+		void fillCandidates( uint, uint );
 
 	public:
 		Graph( int );
 
 		void addEdge( uint, uint, uint, uint, float );
 		void completeCosts();
+		void computeCandidates( uint, int );
 
 		uint size() const;
 		std::vector<Edge*> getAdjList( uint ) const;
-		std::vector<Edge*> getEdges() const;
+		const std::vector<Edge*>& getEdges() const;
 		Edge* getEdge( uint, uint ) const throw( int );
+		uint getDistance( uint, uint ) const;
+		const uint* getDistances( uint ) const;
+		const std::vector<uint>& getNearest( uint ) const;
+		const std::vector<Edge*>& getRequired( uint ) const;
+		const std::vector<Edge*>& getCandidates( uint ) const;
+		std::vector<uint> getDetours( uint, uint, uint, uint = 0 ) const;
 	};
 }
 
@@ -18,5 +18,7 @@
 #endif
 
 typedef unsigned int uint;
+// Impronta di una soluzione ( hash di Zobrist )
+typedef unsigned long long fingerprint;
 
 #endif
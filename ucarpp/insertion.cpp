@@ -0,0 +1,165 @@
+//
+//  insertion.cpp
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#include "insertion.h"
+
+using namespace std;
+using namespace solver;
+using namespace model;
+
+
+/*** Insertions ***/
+
+/**
+ * Costruttore.
+ *
+ * @param graph	il grafo, con la magliatura già completata
+ */
+Insertions::Insertions( const Graph& graph ):
+	graph( graph ), first( 1, 0 ) {}
+
+/**
+ * Dimentica veicoli e posizioni, tenendo la memoria già allocata.
+ */
+void Insertions::clear()
+{
+	index.clear();
+	src.clear();
+	dst.clear();
+	cost.clear();
+	slack.clear();
+	first.assign( 1, 0 );
+	time.clear();
+	room.clear();
+}
+
+/**
+ * Apre un nuovo veicolo: le posizioni aggiunte da qui in poi sono sue.
+ *
+ * @param timeLeft	il tempo ancora a disposizione del veicolo
+ * @param capacity	la capacità ancora libera del veicolo
+ */
+void Insertions::addVehicle( int timeLeft, int capacity )
+{
+	first.push_back( first.back() );
+	time.push_back( timeLeft );
+	room.push_back( capacity );
+}
+
+/**
+ * Aggiunge una posizione all'ultimo veicolo aperto.
+ *
+ * @param slotIndex	l'indice del collegamento da sostituire
+ * @param slotSrc	il nodo di partenza del collegamento
+ * @param slotDst	il nodo di arrivo del collegamento
+ * @param slotCost	il costo del collegamento, 0 per il veicolo vuoto
+ */
+void Insertions::addSlot( int slotIndex, uint slotSrc, uint slotDst, int slotCost )
+{
+	index.push_back( slotIndex );
+	src.push_back( slotSrc );
+	dst.push_back( slotDst );
+	cost.push_back( slotCost );
+	// Il tempo residuo va confrontato col costo del collegamento che viene tolto
+	slack.push_back( time.back() + slotCost );
+	first.back()++;
+}
+
+/**
+ * Valuta l'inserimento del lato in tutte le posizioni, in entrambi i versi.
+ * Per ogni veicolo che ha capacità per il lato restituisce la posizione di punteggio massimo,
+ * dove il punteggio è il profitto per unità di tempo aggiunto; a parità vince la prima posizione
+ * ed il verso che entra da getSrc.
+ *
+ * @param edge	il lato da inserire
+ * @param best	dove scrivere il miglior inserimento di ogni veicolo
+ */
+void Insertions::evaluate( const Edge* edge, vector<Best>* best )
+{
+	int n = (int)src.size();
+	entries.resize( n );
+	scores.resize( n );
+
+	uint u = edge->getSrc(),
+		 w = edge->getDst();
+	int c = edge->getCost();
+	float profit = edge->getProfit();
+	const uint* fromU = graph.getDistances( u );
+	const uint* fromW = graph.getDistances( w );
+	const uint* srcs = src.data();
+	const uint* dsts = dst.data();
+	const int* slacks = slack.data();
+	uint* enters = entries.data();
+	float* values = scores.data();
+
+	// Percorso src -> u -> w -> dst oppure src -> w -> u -> dst, al posto del collegamento:
+	//  il costo del collegamento è già compreso nel tempo residuo della posizione
+	for ( int s = 0; s < n; s++ )
+	{
+		int viaU = (int)fromU[ srcs[ s ] ] + c + (int)fromW[ dsts[ s ] ],
+			viaW = (int)fromW[ srcs[ s ] ] + c + (int)fromU[ dsts[ s ] ];
+		bool forward = viaU <= viaW;
+		int total = forward ? viaU : viaW;
+
+		enters[ s ] = forward ? u : w;
+		values[ s ] = total <= slacks[ s ] ? profit / ( max( total - cost[ s ], 0 ) + 1 ) : 0;
+	}
+
+	uint vehicles = getVehicles();
+	best->assign( vehicles, { 0, -1, 0 } );
+	for ( uint v = 0; v < vehicles; v++ )
+	{
+		if ( room[ v ] < (int)edge->getDemand() )
+			continue;
+
+		Best& vehicleBest = (*best)[ v ];
+		for ( int s = first[ v ]; s < first[ v + 1 ]; s++ )
+			if ( values[ s ] > vehicleBest.score )
+				vehicleBest = { values[ s ], s, enters[ s ] };
+	}
+}
+
+/**
+ * @return	il numero di posizioni
+ */
+unsigned long Insertions::size() const
+{
+	return src.size();
+}
+
+/**
+ * @return	il numero di veicoli aperti
+ */
+uint Insertions::getVehicles() const
+{
+	return (uint)room.size();
+}
+
+/**
+ * @return	l'indice del collegamento della posizione
+ */
+int Insertions::getIndex( int slot ) const
+{
+	return index[ slot ];
+}
+
+/**
+ * @return	il nodo di partenza del collegamento della posizione
+ */
+uint Insertions::getSrc( int slot ) const
+{
+	return src[ slot ];
+}
+
+/**
+ * @return	il nodo di arrivo del collegamento della posizione
+ */
+uint Insertions::getDst( int slot ) const
+{
+	return dst[ slot ];
+}
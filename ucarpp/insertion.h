@@ -0,0 +1,74 @@
+//
+//  insertion.h
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#ifndef __ucarpp__insertion__
+#define __ucarpp__insertion__
+
+#include <vector>
+#include <algorithm>
+
+#include "headings.h"
+#include "edge.h"
+#include "graph.h"
+
+namespace solver
+{
+	/**
+	 * Valutazione in blocco delle posizioni in cui inserire un lato profittevole.
+	 * Le posizioni sono i collegamenti sostituibili dei percorsi, raggruppati per veicolo e tenuti
+	 * per colonne ( indice, estremi, costo, tempo residuo ): per ogni lato le distanze dai suoi estremi
+	 * vengono raccolte dalle righe della matrice delle distanze in vettori contigui, su cui tempo
+	 * aggiunto e punteggio di ogni posizione si calcolano con cicli senza salti, che il compilatore può vettorizzare.
+	 */
+	class Insertions
+	{
+		public:
+			// Miglior inserimento in un veicolo: punteggio ( 0 se non ce ne sono ), posizione ed estremo d'ingresso
+			struct Best
+			{
+				float score;
+				int slot;
+				uint entry;
+			};
+
+		private:
+			const model::Graph& graph;
+
+			// Colonne delle posizioni
+			std::vector<int> index;
+			std::vector<uint> src,
+							  dst;
+			std::vector<int> cost,
+							 slack;
+			// Prima posizione di ogni veicolo ( un elemento in più ), tempo e capacità residui
+			std::vector<int> first;
+			std::vector<int> time,
+							 room;
+
+			// Vettori di lavoro, riusati tra una valutazione e l'altra
+			std::vector<uint> entries;
+			std::vector<float> scores;
+
+		public:
+			Insertions( const model::Graph& );
+
+			void clear();
+			void addVehicle( int, int );
+			void addSlot( int, uint, uint, int );
+
+			void evaluate( const model::Edge*, std::vector<Best>* );
+
+			unsigned long size() const;
+			uint getVehicles() const;
+			int getIndex( int ) const;
+			uint getSrc( int ) const;
+			uint getDst( int ) const;
+	};
+}
+
+#endif /* defined(__ucarpp__insertion__) */
@@ -25,7 +25,7 @@ int main( int argc, const char * argv[] )
 {
 	if ( argc == 0 )
 	{
-		cout << "Usage:" << endl << "\tucarpp path [M]" << endl;
+		cout << "Usage:" << endl << "\tucarpp path [M] [method] [ORG|MDF] [NAME=value ...] [CONFIG=file]" << endl;
 		exit( 1 );
 	}
 	
@@ -256,8 +256,24 @@ int main( int argc, const char * argv[] )
 	else
 		type = "ORG";
 
+	// Leggo gli eventuali parametri della ricerca, nella forma NOME=valore.
+	// CONFIG=file legge i parametri da un file di configurazione.
+	solver::Parameters parameters;
+	for ( int i = 5; i < argc; i++ )
+		if ( !parameters.set( string( argv[ i ] ) ) )
+		{
+			cerr << "Errore nella lettura del parametro " << argv[ i ] << endl;
+			exit( 1 );
+		}
+#ifdef DEBUG
+	cerr << "Parametri: " << parameters.toString() << endl;
+#endif
+
+	// Restringo gli intorni ai candidati di ogni nodo
+	grafo.computeCandidates( parameters.neighbours, parameters.threads );
+
 	// Creo il risolutore
-	solver::Solver solver( grafo, depot, M, Q, tMax );
+	solver::Solver solver( grafo, depot, M, Q, tMax, parameters );
 	// Se richiesto, imposto il nome del file sul quale scrivere i risultati intermedi
 #ifdef OUTPUT_FILE
 	filename = filename.replace( filename.find( "dat" ), 3, to_string( M ) );
@@ -21,6 +21,7 @@
 #include "graph.h"
 #include "solver.h"
 #include "meta.h"
+#include "parameters.h"
 
 
 #endif /* defined(__ucarpp__main__) */
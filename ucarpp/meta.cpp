@@ -17,19 +17,88 @@ using namespace model;
 /**
  * Costruttore
  */
-MetaEdge::MetaEdge( Edge* reference ):
-	actualEdge( reference )
+MetaEdge::MetaEdge( Edge* reference, fingerprint* serverHash ):
+	actualEdge( reference ), serverHash( serverHash )
 {
 	takers = vector<const Vehicle*>();
 }
 
-MetaEdge::MetaEdge( const MetaEdge& source ):
-	actualEdge( source.actualEdge )
+MetaEdge::MetaEdge( const MetaEdge& source, fingerprint* serverHash ):
+	actualEdge( source.actualEdge ), serverHash( serverHash )
 {
 	// TODO: Copio le statistiche ma non i lati passanti
 	takers = vector<const Vehicle*>();
 }
 
+/**
+ * Chiave di Zobrist associata ad un veicolo e ad un lato, ottenuta mescolando i due indici
+ * ( splitmix64 ) invece di tenerne una tabella M x E.
+ * Le impronte sono somme di chiavi, per cui passare più volte sullo stesso lato conta.
+ *
+ * @param vehicle	l'identificativo del veicolo
+ * @param edge		l'indice del lato nel grafo
+ * @param served	vero per la chiave del servizio, falso per quella della percorrenza
+ * @return	la chiave a 64 bit
+ */
+fingerprint MetaEdge::getKey( int vehicle, uint edge, bool served )
+{
+	return mix( ( (fingerprint)vehicle << 33 ) ^ ( (fingerprint)edge << 1 ) ^ served );
+}
+
+/**
+ * Chiave di Zobrist di due lati consecutivi nel percorso di un veicolo.
+ * Sommate su tutte le coppie, rendono l'impronta sensibile all'ordine dei lati;
+ * inserire o togliere un lato cambia solo le coppie dei suoi vicini.
+ *
+ * @param vehicle	l'identificativo del veicolo
+ * @param from		l'indice del lato precedente più uno, 0 per il deposito
+ * @param to		l'indice del lato successivo più uno, 0 per il deposito
+ * @return	la chiave a 64 bit
+ */
+fingerprint MetaEdge::getLinkKey( int vehicle, uint from, uint to )
+{
+	return mix( mix( ( (fingerprint)vehicle << 32 ) ^ from ) ^ ( (fingerprint)to << 1 ) ^ 1 );
+}
+
+/**
+ * Mescola i bit di un intero ( finalizzatore di splitmix64 ).
+ */
+fingerprint MetaEdge::mix( fingerprint x )
+{
+	x += 0x9E3779B97F4A7C15ULL;
+	x = ( x ^ ( x >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+	x = ( x ^ ( x >> 27 ) ) * 0x94D049BB133111EBULL;
+
+	return x ^ ( x >> 31 );
+}
+
+/**
+ * Aggiorna i lati serviti dai veicoli e l'impronta dei serventi dopo una modifica dei passanti.
+ * Conta solo per i lati richiesti, gli unici per cui il servente fa differenza;
+ * l'impronta solo per quelli profittevoli.
+ *
+ * @param previous	il servente prima della modifica, NULL se il lato non era preso
+ */
+void MetaEdge::updateServer( const Vehicle* previous )
+{
+	const Vehicle* current = ( takers.empty() ? NULL : takers.front() );
+	if ( previous == current || ( getProfit() <= 0 && getDemand() <= 0 ) )
+		return;
+
+	if ( previous != NULL )
+		previous->setServed( this, false );
+	if ( current != NULL )
+		current->setServed( this, true );
+
+	if ( serverHash == NULL || getProfit() <= 0 )
+		return;
+
+	if ( previous != NULL )
+		*serverHash -= getKey( previous->getId(), actualEdge->getId(), true );
+	if ( current != NULL )
+		*serverHash += getKey( current->getId(), actualEdge->getId(), true );
+}
+
 uint MetaEdge::getSrc() const
 {
 	return actualEdge->getSrc();
@@ -100,6 +169,8 @@ unsigned long MetaEdge::setTaken( const Vehicle* taker, int occurrence )
 		cerr << "'" << (*it)->getId() << "' ";
 #endif
 */
+	const Vehicle* previous = ( takers.empty() ? NULL : takers.front() );
+
 	// Cerco n le occorrenze del veicolo. Inserisco prima della (n+1)-esima.
 	for ( auto it = takers.begin(); it < takers.end(); ++it )
 		if ( **it == *taker )
@@ -108,11 +179,13 @@ unsigned long MetaEdge::setTaken( const Vehicle* taker, int occurrence )
 				// In caso si usino i reverse_iterator,
 				// bisogna usare .base() facendo piu' o meno ++i--
 				takers.insert( it, taker );
+				updateServer( previous );
 				return takers.size();
 			}
 
 	// Non ho trovato n+1 occorrenze. Inserisco in coda.
 	takers.push_back( taker );
+	updateServer( previous );
 /*	
 #ifdef DEBUG
 	cerr << " ==> ";
@@ -143,6 +216,8 @@ unsigned long MetaEdge::unsetTaken( const Vehicle* taker, int occurrence )
 		cerr << "'" << (*it)->getId() << "' ";
 #endif
 */
+	const Vehicle* previous = ( takers.empty() ? NULL : takers.front() );
+
 	// Cerco il veicolo. Se lo trovo lo cancello, altrimenti niente.
 	for ( auto it = takers.begin(); it < takers.end(); ++it )
 		if ( **it == *taker )
@@ -154,6 +229,8 @@ unsigned long MetaEdge::unsetTaken( const Vehicle* taker, int occurrence )
 				break;
 			}
 
+	updateServer( previous );
+
 /*
 #ifdef DEBUG
 	cerr << " ==> ";
@@ -210,11 +287,13 @@ bool MetaEdge::setServer( const Vehicle* vehicle )
 	for( int i = 0; i < takers.size(); i++ )
 		if( takers[ i ] == vehicle )
 		{
+			const Vehicle* previous = takers.front();
 			// Inserisco il corrente elemento in testa al vettore
 			takers.insert( takers.begin(), takers[ i ] );
 			// Elimino l'elemento stesso dalla posizione in cui si trovava in precedenza,
 			// tenendo conto che ora l'array ha un elemento in più
 			takers.erase( takers.begin() + i + 1 );
+			updateServer( previous );
 			// Sono riuscito a scambiare il server
 			return true;
 		}
@@ -253,16 +332,18 @@ bool MetaEdge::equals( const MetaEdge& other ) const
 /**
  * Costruttore
  */
-MetaGraph::MetaGraph( Graph g )
+MetaGraph::MetaGraph( Graph g ):
+	serverHash( new fingerprint( 0 ) )
 {
 	this->edges = unordered_map<Edge*, MetaEdge*>();
 	
 	for ( Edge* edge : g.getEdges() )
-		edges.insert( make_pair( edge, new MetaEdge( edge ) ) );
+		edges.insert( make_pair( edge, new MetaEdge( edge, serverHash.get() ) ) );
 }
 
 // Costruttore strambo
-MetaGraph::MetaGraph( const MetaGraph& source )
+MetaGraph::MetaGraph( const MetaGraph& source ):
+	serverHash( new fingerprint( 0 ) )
 {
 	// Creo la nuova mappa lati-metalati
 	this->edges = unordered_map<Edge*, MetaEdge*>();
@@ -270,7 +351,7 @@ MetaGraph::MetaGraph( const MetaGraph& source )
 	// Ciclo su tutti i metalati del metagrafo e ne faccio una copia
 	for( auto edge : source.edges )
 	{
-		edges.insert( make_pair( edge.first, new MetaEdge( *edge.second ) ) );
+		edges.insert( make_pair( edge.first, new MetaEdge( *edge.second, serverHash.get() ) ) );
 	}
 }
 
@@ -292,3 +373,12 @@ MetaEdge* MetaGraph::getEdge( const Edge* edge ) const
 	return edges.at( const_cast<Edge*>( edge ) );
 }
 
+/**
+ * Getter della componente dell'impronta dovuta ai serventi dei lati profittevoli,
+ * aggiornata ad ogni cambio di servente.
+ */
+fingerprint MetaGraph::getServerHash() const
+{
+	return *serverHash;
+}
+
@@ -13,6 +13,7 @@
 #include "edge.h"
 #include "graph.h"
 #include <set>
+#include <memory>
 #include <unordered_map>	// If not working: Boost
 
 namespace solver
@@ -25,12 +26,19 @@ namespace solver
 	private:
 		model::Edge* actualEdge;
 		std::vector<const Vehicle*> takers;
+		// Componente dell'impronta del metagrafo dovuta ai serventi, condivisa tra i metalati
+		fingerprint* serverHash;
 		
 		bool equals( const MetaEdge& ) const;
+		void updateServer( const Vehicle* );
+		static fingerprint mix( fingerprint );
 		
 	public:
-		MetaEdge( model::Edge* );
-		MetaEdge( const MetaEdge& );
+		MetaEdge( model::Edge*, fingerprint* = NULL );
+		MetaEdge( const MetaEdge&, fingerprint* = NULL );
+		
+		static fingerprint getKey( int, uint, bool );
+		static fingerprint getLinkKey( int, uint, uint );
 		
 		uint getSrc() const;
 		uint getDst() const;
@@ -63,6 +71,8 @@ namespace solver
 		std::unordered_map<model::Edge*, MetaEdge*> edges;
 		// Lista di Adiacenza
 		//std::unordered_map<uint, MetaEdge*>* adjList;
+		// Condivisa perché l'assegnamento tra soluzioni copia i puntatori ai metalati
+		std::shared_ptr<fingerprint> serverHash;
 		
 	public:
 		MetaGraph( model::Graph );
@@ -71,6 +81,7 @@ namespace solver
 		
 		//			MetaEdge* getEdge( uint, uint ) const throw( int );
 		MetaEdge* getEdge( const model::Edge* ) const;
+		fingerprint getServerHash() const;
 		//			std::unordered_map<model::Edge*, MetaEdge*> getEdges() const;
 		//			std::unordered_map<uint, MetaEdge*> getAdjList( uint ) const;
 	};
@@ -0,0 +1,335 @@
+//
+//  parameters.cpp
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#include "parameters.h"
+
+#include <cmath>
+
+using namespace std;
+using namespace solver;
+
+
+/*** Parameters ***/
+
+/**
+ * Costruttore.
+ * Imposta i valori predefiniti: quelli delle costanti usate fino ad ora dal Solver e, per le
+ * tecniche aggiunte dopo, valori che le lasciano spente. Fanno eccezione il limite di nodi di
+ * EXACT, la memoria delle soluzioni già cercate ( VISITED ) e l'inserimento finale ( INSERTION ).
+ */
+Parameters::Parameters():
+	nIter( 200 ),
+	kMax( 10 ),
+	xi( 4 ),
+	pClose( .25 ),
+	pAccept( .95 ),
+	sigmoid( SIGMOID_ALG ),
+	sigmoidSlope( 0 ),
+	sigmoidCenter( .75 ),
+	gap( 0 ),
+	exactNodes( 2000000 ),
+	threads( 0 ),
+	neighbours( 0 ),
+	visited( 10000 ),
+	firstImprovement( false ),
+	dontLook( false ),
+	tabuTenure( 20 ),
+	tabuCandidates( 10 ),
+	alnsSegment( 50 ),
+	alnsReaction( .1 ),
+	regret( 2 ),
+	insertion( true ),
+	accept( ACCEPT_STRICT ),
+	alnsAccept( ACCEPT_SA ),
+	temperature( 0 ),
+	cooling( .99 ),
+	deviation( .05 ),
+	lahcLength( 50 ),
+	eliteSize( 10 ),
+	relink( false ),
+	routePool( 0 ),
+	poolPeriod( 50 ),
+	population( 30 ),
+	mutation( .2 ),
+	graspAlpha( .3 ),
+	graspStarts( 0 ),
+	savings( false ) {}
+
+/**
+ * Interpreta il nome di un criterio di accettazione.
+ *
+ * @param value		STRICT, SA, TA, RRT, LAHC o GD
+ * @param criterion	dove scrivere il criterio letto
+ * @return	vero, se il nome è valido
+ */
+static bool parseAcceptance( string value, AcceptanceCriterion* criterion )
+{
+	const char* names[] = { "STRICT", "SA", "TA", "RRT", "LAHC", "GD" };
+
+	for ( int i = 0; i <= ACCEPT_GD; i++ )
+		if ( value == names[ i ] )
+		{
+			*criterion = (AcceptanceCriterion)i;
+			return true;
+		}
+
+	return false;
+}
+
+/**
+ * Imposta un parametro a partire dal suo nome.
+ *
+ * @param name	il nome del parametro (es. N_ITER)
+ * @param value	il valore da assegnare
+ * @return	vero, se il parametro esiste ed il valore è stato letto correttamente
+ */
+bool Parameters::set( string name, string value )
+{
+	try
+	{
+		if ( name == "N_ITER" )
+			nIter = stoi( value );
+		else if ( name == "K_MAX" )
+			kMax = stoi( value );
+		else if ( name == "XI" )
+			xi = stof( value );
+		else if ( name == "P_CLOSE" )
+			pClose = stof( value );
+		else if ( name == "P_ACCEPT" )
+			pAccept = stof( value );
+		else if ( name == "SIGMOID" )
+		{
+			if ( value == "ATAN" )
+				sigmoid = SIGMOID_ATAN;
+			else if ( value == "TANH" )
+				sigmoid = SIGMOID_TANH;
+			else if ( value == "ERF" )
+				sigmoid = SIGMOID_ERF;
+			else if ( value == "ALG" )
+				sigmoid = SIGMOID_ALG;
+			else
+				return false;
+		}
+		else if ( name == "SIGMOID_SLOPE" )
+			sigmoidSlope = stof( value );
+		else if ( name == "SIGMOID_CENTER" )
+			sigmoidCenter = stof( value );
+		else if ( name == "GAP" )
+			gap = stof( value );
+		else if ( name == "EXACT_NODES" )
+			exactNodes = stol( value );
+		else if ( name == "THREADS" )
+			threads = stoi( value );
+		else if ( name == "NEIGHBOURS" )
+			neighbours = max( 0, stoi( value ) );
+		else if ( name == "VISITED" )
+			visited = max( 0, stoi( value ) );
+		else if ( name == "FIRST_IMPROVEMENT" )
+			firstImprovement = stoi( value ) != 0;
+		else if ( name == "DONT_LOOK" )
+			dontLook = stoi( value ) != 0;
+		else if ( name == "TABU_TENURE" )
+			tabuTenure = stoi( value );
+		else if ( name == "TABU_CANDIDATES" )
+			tabuCandidates = stoi( value );
+		else if ( name == "ALNS_SEGMENT" )
+			alnsSegment = stoi( value );
+		else if ( name == "ALNS_REACTION" )
+			alnsReaction = stof( value );
+		else if ( name == "REGRET_K" )
+			regret = max( 2, stoi( value ) );
+		else if ( name == "INSERTION" )
+			insertion = stoi( value ) != 0;
+		else if ( name == "ACCEPT" )
+			return parseAcceptance( value, &accept );
+		else if ( name == "ALNS_ACCEPT" )
+			return parseAcceptance( value, &alnsAccept );
+		else if ( name == "TEMPERATURE" )
+			temperature = stof( value );
+		else if ( name == "COOLING" )
+			cooling = stof( value );
+		else if ( name == "DEVIATION" )
+			deviation = stof( value );
+		else if ( name == "LAHC_LENGTH" )
+			lahcLength = stoi( value );
+		else if ( name == "ELITE_SIZE" )
+			eliteSize = max( 0, stoi( value ) );
+		else if ( name == "RELINK" )
+			relink = stoi( value ) != 0;
+		else if ( name == "ROUTE_POOL" )
+			routePool = max( 0, stoi( value ) );
+		else if ( name == "POOL_PERIOD" )
+			poolPeriod = max( 0, stoi( value ) );
+		else if ( name == "POPULATION" )
+			population = stoi( value );
+		else if ( name == "MUTATION" )
+			mutation = stof( value );
+		else if ( name == "GRASP_ALPHA" )
+			graspAlpha = min( 1.f, max( 0.f, stof( value ) ) );
+		else if ( name == "GRASP_STARTS" )
+			graspStarts = max( 0, stoi( value ) );
+		else if ( name == "SAVINGS" )
+			savings = stoi( value ) != 0;
+		else if ( name == "CONFIG" )
+			return load( value );
+		else
+			return false;
+	}
+	catch ( ... )
+	{
+		return false;
+	}
+
+	// K_MAX viene usato come modulo: non può essere nullo
+	if ( kMax < 1 )
+		kMax = 1;
+	// Così come la lunghezza del segmento della ALNS e quella della storia del LAHC
+	if ( alnsSegment < 1 )
+		alnsSegment = 1;
+	if ( lahcLength < 1 )
+		lahcLength = 1;
+	// Il torneo richiede almeno due individui
+	if ( population < 2 )
+		population = 2;
+
+	return true;
+}
+
+/**
+ * Imposta un parametro a partire da una stringa nella forma NOME=valore.
+ *
+ * @param assignment	la stringa da interpretare
+ * @return	vero, se l'assegnamento è andato a buon fine
+ */
+bool Parameters::set( string assignment )
+{
+	size_t equal = assignment.find( '=' );
+	if ( equal == string::npos )
+		return false;
+
+	return set( assignment.substr( 0, equal ), assignment.substr( equal + 1 ) );
+}
+
+/**
+ * Legge i parametri da un file di configurazione.
+ * Ogni riga contiene NOME valore oppure NOME=valore; tutto ciò che segue # viene ignorato.
+ *
+ * @param filename	il percorso del file
+ * @return	vero, se il file esiste e tutte le righe sono state interpretate
+ */
+bool Parameters::load( string filename )
+{
+	ifstream in( filename );
+	if ( !in.is_open() )
+		return false;
+
+	bool result = true;
+	string line;
+	while ( getline( in, line ) )
+	{
+		// Elimino i commenti
+		size_t comment = line.find( '#' );
+		if ( comment != string::npos )
+			line.erase( comment );
+
+		// Accetto indifferentemente spazi o uguale come separatore
+		for ( char& c : line )
+			if ( c == '=' )
+				c = ' ';
+
+		stringstream ss( line );
+		string name, value;
+		if ( !( ss >> name ) )
+			continue;
+
+		if ( !( ss >> value ) || !set( name, value ) )
+			result = false;
+	}
+
+	return result;
+}
+
+/**
+ * Calcola la probabilità di effettuare una mutazione in chiusura.
+ *
+ * @param x	media tra domanda e costo del veicolo, normalizzati rispetto a Q e tMax
+ * @return	il valore della sigmoide scelta centrata in sigmoidCenter
+ */
+float Parameters::getCloseProbability( float x ) const
+{
+	x -= sigmoidCenter;
+
+	switch ( sigmoid )
+	{
+		// Arcotangente
+		case SIGMOID_ATAN:
+			return atan( ( sigmoidSlope ? sigmoidSlope : 50 ) * x ) / M_PI + .5;
+
+		// Tangente iperbolica
+		case SIGMOID_TANH:
+			return tanh( ( sigmoidSlope ? sigmoidSlope : 15 ) * x ) + .5;
+
+		// Funzione errore
+		case SIGMOID_ERF:
+			return erf( ( sigmoidSlope ? sigmoidSlope : 10 ) * x ) + .5;
+
+		// Funzione x / sqrt( 1 + x^2 )
+		case SIGMOID_ALG:
+		default:
+		{
+			float s = ( sigmoidSlope ? sigmoidSlope : 15 );
+			return .5 * s * x / sqrt( s * s * x * x + 1 );
+		}
+	}
+}
+
+string Parameters::toString() const
+{
+	const char* sigmoids[] = { "ATAN", "TANH", "ERF", "ALG" };
+	const char* acceptances[] = { "STRICT", "SA", "TA", "RRT", "LAHC", "GD" };
+
+	stringstream ss;
+	ss << "N_ITER=" << nIter;
+	ss << " K_MAX=" << kMax;
+	ss << " XI=" << xi;
+	ss << " P_CLOSE=" << pClose;
+	ss << " P_ACCEPT=" << pAccept;
+	ss << " SIGMOID=" << sigmoids[ sigmoid ];
+	ss << " SIGMOID_SLOPE=" << sigmoidSlope;
+	ss << " SIGMOID_CENTER=" << sigmoidCenter;
+	ss << " GAP=" << gap;
+	ss << " EXACT_NODES=" << exactNodes;
+	ss << " THREADS=" << threads;
+	ss << " NEIGHBOURS=" << neighbours;
+	ss << " VISITED=" << visited;
+	ss << " FIRST_IMPROVEMENT=" << firstImprovement;
+	ss << " DONT_LOOK=" << dontLook;
+	ss << " TABU_TENURE=" << tabuTenure;
+	ss << " TABU_CANDIDATES=" << tabuCandidates;
+	ss << " ALNS_SEGMENT=" << alnsSegment;
+	ss << " ALNS_REACTION=" << alnsReaction;
+	ss << " REGRET_K=" << regret;
+	ss << " INSERTION=" << insertion;
+	ss << " ACCEPT=" << acceptances[ accept ];
+	ss << " ALNS_ACCEPT=" << acceptances[ alnsAccept ];
+	ss << " TEMPERATURE=" << temperature;
+	ss << " COOLING=" << cooling;
+	ss << " DEVIATION=" << deviation;
+	ss << " LAHC_LENGTH=" << lahcLength;
+	ss << " ELITE_SIZE=" << eliteSize;
+	ss << " RELINK=" << relink;
+	ss << " ROUTE_POOL=" << routePool;
+	ss << " POOL_PERIOD=" << poolPeriod;
+	ss << " POPULATION=" << population;
+	ss << " MUTATION=" << mutation;
+	ss << " GRASP_ALPHA=" << graspAlpha;
+	ss << " GRASP_STARTS=" << graspStarts;
+	ss << " SAVINGS=" << savings;
+
+	return ss.str();
+}
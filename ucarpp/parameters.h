@@ -0,0 +1,131 @@
+//
+//  parameters.h
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#ifndef __ucarpp__parameters__
+#define __ucarpp__parameters__
+
+#include <string>
+#include <fstream>
+#include <sstream>
+
+#include "headings.h"
+
+namespace solver
+{
+	// Funzioni sigmoidali utilizzabili per pesare la probabilità di chiusura nella mutateSolution
+	enum Sigmoid
+	{
+		SIGMOID_ATAN,
+		SIGMOID_TANH,
+		SIGMOID_ERF,
+		SIGMOID_ALG
+	};
+
+	// Criteri di accettazione di una soluzione non migliorante
+	enum AcceptanceCriterion
+	{
+		ACCEPT_STRICT,
+		ACCEPT_SA,
+		ACCEPT_TA,
+		ACCEPT_RRT,
+		ACCEPT_LAHC,
+		ACCEPT_GD
+	};
+
+	/**
+	 * Parametri della ricerca, modificabili da linea di comando (NOME=valore)
+	 * o da file di configurazione (una coppia NOME valore per riga, # per i commenti).
+	 */
+	class Parameters
+	{
+		public:
+			int		nIter;
+			int		kMax;
+			float	xi;
+			float	pClose;
+			float	pAccept;
+
+			Sigmoid	sigmoid;
+			// Pendenza della sigmoide: 0 indica il valore storico della funzione scelta
+			float	sigmoidSlope;
+			// Punto di flesso della sigmoide, rispetto alla media di domanda e costo normalizzati
+			float	sigmoidCenter;
+
+			// Gap relativo dal limite superiore sotto il quale la ricerca si ferma
+			float	gap;
+
+			// Numero massimo di nodi del branch and bound ( qualche secondo ), 0 per nessun limite
+			long	exactNodes;
+			// Numero di thread, 0 per usarne uno per core
+			int		threads;
+			// Nodi più vicini tra cui cercare aperture e chiusure, 0 per considerarli tutti
+			int		neighbours;
+			// Impronte ricordate delle soluzioni già cercate da VNS e VND, 0 per non tenerne
+			int		visited;
+			// Ricerca locale ( VNS ed optimizeSolution ): ferma al primo miglioramento invece che al migliore,
+			//  e senza ripetere le posizioni già cercate di un percorso rimasto uguale ( spento di
+			//  default: salta chiusure che tornano utili quando cambia il resto della soluzione )
+			bool	firstImprovement;
+			bool	dontLook;
+
+			// Tabu search: iterazioni per cui un'impronta resta proibita e mosse valutate per iterazione
+			int		tabuTenure;
+			int		tabuCandidates;
+
+			// ALNS: iterazioni tra due aggiornamenti dei pesi degli operatori e fattore di reazione
+			int		alnsSegment;
+			float	alnsReaction;
+			// Rimpianto-k della riparazione della ALNS e inserimento greedy dei lati liberi al termine
+			//  di ogni ottimizzazione, che usa il tempo e la capacità liberati dalle chiusure
+			int		regret;
+			bool	insertion;
+
+			// Criterio di accettazione di VNS e VND ( di default solo miglioramenti ) e della ALNS
+			AcceptanceCriterion	accept;
+			AcceptanceCriterion	alnsAccept;
+			// Temperatura iniziale ( 0 per ricavarla dalla soluzione di partenza ) e raffreddamento,
+			//  usato anche per la soglia del threshold accepting
+			float	temperature;
+			float	cooling;
+			// Peggioramento relativo ammesso da soglie, record to record e livello iniziale del diluvio
+			float	deviation;
+			// Lunghezza della storia del late acceptance hill climbing
+			int		lahcLength;
+
+			// Numero di soluzioni del pool d'élite e path relinking al termine della ricerca
+			int		eliteSize;
+			bool	relink;
+
+			// Percorsi tenuti dal pool di VNS e VND ( 0 per non tenerne ) e iterazioni tra due ricombinazioni
+			int		routePool;
+			int		poolPeriod;
+
+			// Algoritmo memetico: dimensione della popolazione e probabilità di mutazione di un figlio
+			int		population;
+			float	mutation;
+
+			// GRASP: ampiezza della lista ristretta dei candidati ( 0 per la greedy, 1 per una scelta casuale )
+			//  e numero di costruzioni da cui far partire gli altri metodi, 0 per partire dalla greedy
+			float	graspAlpha;
+			int		graspStarts;
+			// Parte dalla costruzione per risparmi, se migliore di quella greedy
+			bool	savings;
+
+			Parameters();
+
+			bool set( std::string, std::string );
+			bool set( std::string );
+			bool load( std::string );
+
+			float getCloseProbability( float ) const;
+
+			std::string toString() const;
+	};
+}
+
+#endif /* defined(__ucarpp__parameters__) */
@@ -0,0 +1,202 @@
+//
+//  pool.cpp
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#include "pool.h"
+
+using namespace std;
+using namespace solver;
+using namespace model;
+
+
+/*** RoutePool ***/
+
+/**
+ * Costruttore.
+ *
+ * @param capacity	il numero massimo di percorsi, 0 per non tenerne
+ * @param graph		il grafo, con la magliatura già completata
+ * @param depot		il deposito
+ */
+RoutePool::RoutePool( uint capacity, const Graph& graph, uint depot ):
+	capacity( capacity ), graph( graph ), depot( depot ) {}
+
+/**
+ * Impronta FNV-1a dell'insieme dei lati serviti.
+ */
+fingerprint RoutePool::getKey( const boost::dynamic_bitset<>& served ) const
+{
+	fingerprint key = 14695981039346656037ULL;
+	for ( size_t i = served.find_first(); i != boost::dynamic_bitset<>::npos; i = served.find_next( i ) )
+		key = ( key ^ i ) * 1099511628211ULL;
+
+	return key;
+}
+
+/**
+ * @return	il profitto dei lati dell'insieme
+ */
+float RoutePool::getProfit( const boost::dynamic_bitset<>& served ) const
+{
+	const vector<Edge*>& edges = graph.getEdges();
+
+	float profit = 0;
+	for ( size_t i = served.find_first(); i != boost::dynamic_bitset<>::npos; i = served.find_next( i ) )
+		profit += edges[ i ]->getProfit();
+
+	return profit;
+}
+
+/**
+ * Propone un percorso al pool.
+ * Un percorso che serve gli stessi lati di uno già presente lo sostituisce solo se più breve;
+ * a pool pieno, un percorso nuovo prende il posto del meno profittevole se lo supera.
+ *
+ * @param route	il percorso proposto
+ * @return	vero, se il percorso è entrato nel pool
+ */
+bool RoutePool::offer( const Route& route )
+{
+	if ( !capacity || !route.size() )
+		return false;
+
+	boost::dynamic_bitset<> served( graph.getEdges().size() );
+	for ( int i = 0; i < route.size(); i++ )
+		served.set( route.getService( i )->getId() );
+
+	fingerprint key = getKey( served );
+	float profit = getProfit( served );
+
+	auto it = index.find( key );
+	if ( it != index.end() )
+	{
+		Entry& entry = routes[ it->second ];
+		if ( entry.served != served || entry.route.getCost() <= route.getCost() )
+			return false;
+
+		entry.route = route;
+		return true;
+	}
+
+	if ( routes.size() < capacity )
+	{
+		index[ key ] = (int)routes.size();
+		routes.push_back( { route, served, profit } );
+		return true;
+	}
+
+	int victim = 0;
+	for ( int i = 1; i < routes.size(); i++ )
+		if ( routes[ i ].profit < routes[ victim ].profit ||
+			 ( routes[ i ].profit == routes[ victim ].profit && routes[ i ].route.getCost() > routes[ victim ].route.getCost() ) )
+			victim = i;
+
+	if ( routes[ victim ].profit >= profit )
+		return false;
+
+	index.erase( getKey( routes[ victim ].served ) );
+	index[ key ] = victim;
+	routes[ victim ] = { route, served, profit };
+
+	return true;
+}
+
+/**
+ * Propone al pool i percorsi di tutti i veicoli di una soluzione ammissibile.
+ */
+void RoutePool::offer( const Solution& solution )
+{
+	if ( !capacity )
+		return;
+
+	for ( int v = 0; v < solution.getVehicles(); v++ )
+		offer( Route( solution, v, graph, depot ) );
+}
+
+unsigned long RoutePool::size() const
+{
+	return routes.size();
+}
+
+/**
+ * Passo del branch and bound: decide se prendere il percorso order[ i ].
+ * Il limite somma al profitto corrente quelli dei percorsi successivi più ricchi,
+ * tanti quanti i veicoli ancora liberi.
+ *
+ * @param packing	lo stato della ricerca
+ * @param i			la posizione in packing->order del percorso da decidere
+ * @param profit	il profitto dei percorsi già presi, senza ripetizioni
+ */
+void RoutePool::pack( Packing* packing, int i, float profit ) const
+{
+	if ( profit > packing->bestProfit )
+	{
+		packing->bestProfit = profit;
+		packing->best = packing->current;
+	}
+
+	uint free = packing->M - (uint)packing->current.size();
+	if ( !free || i >= packing->order.size() || packing->nodes++ >= MAX_NODES )
+		return;
+
+	// Percorsi ordinati per profitto decrescente: i successivi free sono i più ricchi rimasti
+	float bound = profit + packing->remaining[ i ] - packing->remaining[ min( i + free, (uint)packing->order.size() ) ];
+	if ( bound <= packing->bestProfit )
+		return;
+
+	const Entry& entry = routes[ packing->order[ i ] ];
+	float gain = getProfit( entry.served - packing->covered );
+	if ( gain > 0 )
+	{
+		boost::dynamic_bitset<> covered = packing->covered;
+		packing->covered |= entry.served;
+		packing->current.push_back( packing->order[ i ] );
+
+		pack( packing, i + 1, profit + gain );
+
+		packing->current.pop_back();
+		packing->covered = covered;
+	}
+
+	pack( packing, i + 1, profit );
+}
+
+/**
+ * Ricombina i percorsi del pool in una soluzione.
+ *
+ * @param M	il numero di veicoli
+ * @return	la soluzione formata dai percorsi scelti, uno per veicolo
+ */
+Solution RoutePool::recombine( uint M ) const
+{
+	Packing packing;
+	packing.M = M;
+	packing.nodes = 0;
+	packing.covered = boost::dynamic_bitset<>( graph.getEdges().size() );
+	packing.bestProfit = 0;
+
+	for ( int i = 0; i < routes.size(); i++ )
+		packing.order.push_back( i );
+	sort( packing.order.begin(), packing.order.end(),
+		  [ & ]( int lhs, int rhs )
+		  {
+			  return routes[ lhs ].profit > routes[ rhs ].profit;
+		  } );
+
+	// remaining[ i ]: profitto dei percorsi da order[ i ] in poi
+	packing.remaining = vector<float>( routes.size() + 1, 0 );
+	for ( int i = (int)routes.size() - 1; i >= 0; i-- )
+		packing.remaining[ i ] = packing.remaining[ i + 1 ] + routes[ packing.order[ i ] ].profit;
+
+	pack( &packing, 0, 0 );
+
+	Solution result( M, graph );
+	for ( int v = 0; v < packing.best.size(); v++ )
+		routes[ packing.best[ v ] ].route.apply( &result, v );
+
+	return result;
+}
@@ -0,0 +1,80 @@
+//
+//  pool.h
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#ifndef __ucarpp__pool__
+#define __ucarpp__pool__
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <boost/dynamic_bitset.hpp>
+
+#include "headings.h"
+#include "edge.h"
+#include "graph.h"
+#include "solution.h"
+#include "route.h"
+
+namespace solver
+{
+	/**
+	 * Insieme limitato di percorsi ammissibili incontrati dalla ricerca, distinti in base ai lati
+	 * che servono ( indicizzati con Edge::getId ): a parità di servizi resta il percorso più breve.
+	 * La ricombinazione è un set packing risolto per branch and bound: sceglie al più M percorsi
+	 * che massimizzano il profitto servito, contando una volta sola i lati serviti da più percorsi.
+	 * Percorsi presi da soluzioni ammissibili restano ammissibili anche insieme, perché un lato
+	 * servito da altri non pesa sul carico.
+	 */
+	class RoutePool
+	{
+		private:
+			// Nodi massimi del branch and bound di una ricombinazione
+			static const long MAX_NODES = 100000;
+
+			struct Entry
+			{
+				Route route;
+				boost::dynamic_bitset<> served;
+				float profit;
+			};
+
+			// Stato della ricerca del set packing
+			struct Packing
+			{
+				std::vector<int> order;
+				std::vector<float> remaining;
+				uint M;
+				long nodes;
+				boost::dynamic_bitset<> covered;
+				std::vector<int> current,
+								 best;
+				float bestProfit;
+			};
+
+			uint capacity;
+			const model::Graph& graph;
+			uint depot;
+			std::vector<Entry> routes;
+			std::unordered_map<fingerprint, int> index;
+
+			fingerprint getKey( const boost::dynamic_bitset<>& ) const;
+			float getProfit( const boost::dynamic_bitset<>& ) const;
+			void pack( Packing*, int, float ) const;
+
+		public:
+			RoutePool( uint, const model::Graph&, uint );
+
+			bool offer( const Route& );
+			void offer( const Solution& );
+
+			unsigned long size() const;
+			Solution recombine( uint ) const;
+	};
+}
+
+#endif /* defined(__ucarpp__pool__) */
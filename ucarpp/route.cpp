@@ -0,0 +1,403 @@
+//
+//  route.cpp
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#include "route.h"
+
+using namespace std;
+using namespace solver;
+using namespace model;
+
+
+/*** Route ***/
+
+/**
+ * Costruttore di un percorso vuoto.
+ *
+ * @param graph	il grafo, con la magliatura già completata
+ * @param depot	il deposito
+ */
+Route::Route( const Graph& graph, uint depot ):
+	graph( &graph ), depot( depot ), links( 1 )
+{
+	update();
+}
+
+/**
+ * Costruttore a partire dal percorso di un veicolo: tiene i lati che il veicolo serve,
+ * nell'ordine e nel verso della loro prima percorrenza, ed i lati che li collegano.
+ *
+ * @param solution	la soluzione
+ * @param vehicle	il veicolo
+ * @param graph		il grafo, con la magliatura già completata
+ * @param depot		il deposito
+ */
+Route::Route( const Solution& solution, uint vehicle, const Graph& graph, uint depot ):
+	graph( &graph ), depot( depot )
+{
+	Vehicle* aVehicle = solution.getVehicle( vehicle );
+	vector<const Edge*> seen;
+	vector<Edge*> link;
+
+	uint previous = depot;
+	for ( int i = 0; i < solution.size( vehicle ); i++ )
+	{
+		MetaEdge* edge = solution.getEdge( vehicle, i );
+
+		if ( ( edge->getProfit() > 0 || edge->getDemand() > 0 ) && edge->isServer( aVehicle ) &&
+			 find( seen.begin(), seen.end(), edge->getEdge() ) == seen.end() )
+		{
+			services.push_back( edge->getEdge() );
+			entries.push_back( previous );
+			shared.push_back( edge->getTaken() > 1 );
+			links.push_back( link );
+			link.clear();
+		}
+		else
+			link.push_back( edge->getEdge() );
+
+		seen.push_back( edge->getEdge() );
+		previous = edge->getDst( previous );
+	}
+	links.push_back( link );
+
+	update();
+}
+
+// Ricalcola i costi dei collegamenti e le somme prefisse
+void Route::update()
+{
+	linkCosts.clear();
+	for ( auto& link : links )
+	{
+		uint cost = 0;
+		for ( Edge* edge : link )
+			cost += edge->getCost();
+		linkCosts.push_back( cost );
+	}
+
+	costs.assign( 1, 0 );
+	loads.assign( 1, 0 );
+
+	for ( int i = 0; i < services.size(); i++ )
+	{
+		costs.push_back( costs.back() + linkCosts[ i ] + services[ i ]->getCost() );
+		loads.push_back( loads.back() + services[ i ]->getDemand() );
+	}
+}
+
+unsigned long Route::size() const
+{
+	return services.size();
+}
+
+model::Edge* Route::getService( int i ) const
+{
+	return services[ i ];
+}
+
+// Nodo da cui il servizio viene percorso
+uint Route::getEntry( int i ) const
+{
+	return entries[ i ];
+}
+
+// Nodo in cui il servizio termina
+uint Route::getExit( int i ) const
+{
+	return services[ i ]->getDst( entries[ i ] );
+}
+
+bool Route::isShared( int i ) const
+{
+	return shared[ i ];
+}
+
+// Costo complessivo, ritorno al deposito compreso: è quello del veicolo da cui è stato letto
+uint Route::getCost() const
+{
+	return costs.back() + linkCosts.back();
+}
+
+uint Route::getLoad() const
+{
+	return loads.back();
+}
+
+/**
+ * Tratto dei servizi da begin ad end escluso, in tempo costante.
+ * Le distanze sono simmetriche, per cui il tratto invertito ha lo stesso costo interno.
+ *
+ * @param begin		il primo servizio
+ * @param end		il servizio che segue l'ultimo
+ * @param reversed	se percorrere il tratto al contrario
+ */
+Segment Route::getSegment( int begin, int end, bool reversed ) const
+{
+	Segment segment;
+	segment.route = this;
+	segment.edge = NULL;
+	segment.begin = begin;
+	segment.end = end;
+	segment.reversed = reversed;
+	segment.first = segment.last = depot;
+	segment.cost = segment.load = 0;
+
+	if ( begin == end )
+		return segment;
+
+	segment.first = entries[ begin ];
+	segment.last = getExit( end - 1 );
+	segment.cost = costs[ end ] - costs[ begin ] - linkCosts[ begin ];
+	segment.load = loads[ end ] - loads[ begin ];
+
+	if ( reversed )
+		swap( segment.first, segment.last );
+
+	return segment;
+}
+
+/**
+ * Tratto formato da un solo servizio esterno al percorso.
+ *
+ * @param edge	il lato da servire
+ * @param entry	l'estremo da cui percorrerlo
+ */
+Segment Route::getSegment( Edge* edge, uint entry ) const
+{
+	Segment segment;
+	segment.route = NULL;
+	segment.edge = edge;
+	segment.begin = 0;
+	segment.end = 1;
+	segment.reversed = false;
+	segment.first = entry;
+	segment.last = edge->getDst( entry );
+	segment.cost = edge->getCost();
+	segment.load = edge->getDemand();
+
+	return segment;
+}
+
+/**
+ * @return	il costo del percorso che parte dal deposito, concatena i tratti e vi torna
+ */
+uint Route::evaluate( const vector<Segment>& segments ) const
+{
+	uint node = depot,
+		 cost = 0;
+
+	for ( const Segment& segment : segments )
+		if ( !segment.empty() )
+		{
+			cost += graph->getDistance( node, segment.first ) + segment.cost;
+			node = segment.last;
+		}
+
+	return cost + graph->getDistance( node, depot );
+}
+
+/**
+ * Concatena i tratti, in tempo lineare nel numero di servizi: i collegamenti interni ai tratti
+ * vengono conservati ( invertiti, se il tratto è invertito ), quelli tra un tratto e l'altro
+ * sono i lati diretti.
+ *
+ * @return	il percorso risultante
+ */
+Route Route::assemble( const vector<Segment>& segments ) const
+{
+	Route result( *graph, depot );
+	result.links.clear();
+
+	// Collegamento diretto tra due nodi, vuoto se coincidono
+	auto direct = [ & ]( uint src, uint dst ) -> vector<Edge*>
+	{
+		if ( src == dst )
+			return vector<Edge*>();
+		return vector<Edge*>( 1, graph->getEdge( src, dst ) );
+	};
+
+	uint node = depot;
+	for ( const Segment& segment : segments )
+	{
+		if ( segment.empty() )
+			continue;
+
+		result.links.push_back( direct( node, segment.first ) );
+		node = segment.last;
+
+		if ( segment.route == NULL )
+		{
+			result.services.push_back( segment.edge );
+			result.entries.push_back( segment.first );
+			result.shared.push_back( false );
+			continue;
+		}
+
+		const Route& source = *segment.route;
+		for ( int k = 0; k < segment.end - segment.begin; k++ )
+		{
+			int i;
+			if ( segment.reversed )
+			{
+				i = segment.end - 1 - k;
+				result.entries.push_back( source.getExit( i ) );
+				// Al contrario, si arriva al servizio i col collegamento che lo seguiva
+				if ( k > 0 )
+					result.links.push_back( vector<Edge*>( source.links[ i + 1 ].rbegin(), source.links[ i + 1 ].rend() ) );
+			}
+			else
+			{
+				i = segment.begin + k;
+				result.entries.push_back( source.entries[ i ] );
+				if ( k > 0 )
+					result.links.push_back( source.links[ i ] );
+			}
+
+			result.services.push_back( source.services[ i ] );
+			result.shared.push_back( source.shared[ i ] );
+		}
+	}
+	result.links.push_back( direct( node, depot ) );
+
+	result.update();
+	return result;
+}
+
+/**
+ * Sceglie il verso di ogni servizio, tenendone l'ordine, in modo da minimizzare il costo dei collegamenti.
+ * Programmazione dinamica sul verso dell'ultimo servizio percorso, in O( n ).
+ *
+ * @return	il percorso coi versi ottimi, collegati dai lati diretti
+ */
+Route Route::orient() const
+{
+	int n = (int)services.size();
+	if ( n == 0 )
+		return *this;
+
+	// Estremi del servizio i nel verso o: 0 è quello attuale, 1 quello opposto
+	auto entry = [ & ]( int i, int o ) -> uint
+	{
+		return ( o ? getExit( i ) : entries[ i ] );
+	};
+	auto exit = [ & ]( int i, int o ) -> uint
+	{
+		return ( o ? entries[ i ] : getExit( i ) );
+	};
+
+	// cost[ i ][ o ]: costo minimo fino all'uscita del servizio i percorso nel verso o
+	vector< array<uint, 2> > cost( n );
+	vector< array<int, 2> > previous( n );
+	for ( int o = 0; o < 2; o++ )
+	{
+		cost[ 0 ][ o ] = graph->getDistance( depot, entry( 0, o ) ) + services[ 0 ]->getCost();
+		previous[ 0 ][ o ] = 0;
+	}
+
+	for ( int i = 1; i < n; i++ )
+		for ( int o = 0; o < 2; o++ )
+		{
+			cost[ i ][ o ] = UINT_MAX;
+			for ( int p = 0; p < 2; p++ )
+			{
+				uint candidate = cost[ i - 1 ][ p ] + graph->getDistance( exit( i - 1, p ), entry( i, o ) );
+				if ( candidate < cost[ i ][ o ] )
+				{
+					cost[ i ][ o ] = candidate;
+					previous[ i ][ o ] = p;
+				}
+			}
+			cost[ i ][ o ] += services[ i ]->getCost();
+		}
+
+	int o = ( cost[ n - 1 ][ 1 ] + graph->getDistance( exit( n - 1, 1 ), depot ) <
+			  cost[ n - 1 ][ 0 ] + graph->getDistance( exit( n - 1, 0 ), depot ) );
+
+	// Ricostruisco i versi a ritroso
+	vector<Segment> segments( n );
+	for ( int i = n - 1; i >= 0; i-- )
+	{
+		segments[ i ] = getSegment( i, i + 1, o );
+		o = previous[ i ][ o ];
+	}
+
+	return assemble( segments );
+}
+
+/**
+ * Riscrive il percorso del veicolo coi servizi ed i loro collegamenti.
+ * Il veicolo resta il servente dei suoi servizi, anche di quelli percorsi da altri.
+ * I lati diretti possono servire lati profittevoli ancora liberi: l'ammissibilità va ricontrollata.
+ *
+ * @param solution	la soluzione da modificare
+ * @param vehicle	il veicolo
+ */
+void Route::apply( Solution* solution, uint vehicle ) const
+{
+	while ( solution->size( vehicle ) )
+		solution->removeEdge( vehicle );
+
+	for ( int i = 0; i <= services.size(); i++ )
+	{
+		for ( Edge* edge : links[ i ] )
+			solution->addEdge( edge, vehicle );
+		if ( i < services.size() )
+			solution->addEdge( services[ i ], vehicle );
+	}
+
+	// Riaggiunto in fondo ai lati, il veicolo perderebbe il servizio di quelli condivisi
+	Vehicle* aVehicle = solution->getVehicle( vehicle );
+	for ( Edge* service : services )
+		solution->getMetaEdge( service )->setServer( aVehicle );
+}
+
+/**
+ * Sequenza dei servizi, nello stesso formato di Vehicle::toServicesSequence.
+ */
+string Route::toServicesSequence() const
+{
+	stringstream ss;
+	for ( int i = 0; i < services.size(); i++ )
+		if ( services[ i ]->getProfit() > 0 )
+			ss << entries[ i ] + 1 << "-" << getExit( i ) + 1 << " ";
+
+	return ss.str();
+}
+
+/**
+ * Sequenza dei nodi, nello stesso formato di Vehicle::toVertexSequence.
+ */
+string Route::toVertexSequence() const
+{
+	if ( services.empty() && links[ 0 ].empty() )
+		return "";
+
+	stringstream ss;
+	ss << depot + 1 << " ";
+
+	uint node = depot;
+	for ( int i = 0; i <= services.size(); i++ )
+	{
+		for ( Edge* edge : links[ i ] )
+		{
+			node = edge->getDst( node );
+			ss << node + 1 << " ";
+		}
+
+		if ( i == services.size() )
+			break;
+
+		node = getExit( i );
+		if ( services[ i ]->getProfit() > 0 )
+			ss << "(" << entries[ i ] + 1 << " " << node + 1 << ") ";
+		else
+			ss << node + 1 << " ";
+	}
+
+	return ss.str();
+}
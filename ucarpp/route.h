@@ -0,0 +1,111 @@
+//
+//  route.h
+//  ucarpp
+//
+//  Created by Maurizio Zucchelli on 2013-06-10.
+//  Copyright (c) 2013 Marco Maddiona, Riccardo Orizio, Mattia Rizzini, Maurizio Zucchelli. All rights reserved.
+//
+
+#ifndef __ucarpp__route__
+#define __ucarpp__route__
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <array>
+
+#include "headings.h"
+#include "edge.h"
+#include "graph.h"
+#include "solution.h"
+
+namespace solver
+{
+	class Route;
+
+	/**
+	 * Tratto di servizi consecutivi di un Route, eventualmente percorso al contrario.
+	 * Conosce gli estremi, il costo interno ( collegamenti compresi ) ed il carico,
+	 * per cui concatenare più tratti costa O( 1 ) per tratto.
+	 */
+	struct Segment
+	{
+		// Percorso da cui viene il tratto, oppure il singolo lato che lo forma
+		const Route* route;
+		model::Edge* edge;
+		int begin,
+			end;
+		bool reversed;
+
+		// Nodo di ingresso nel primo servizio e di uscita dall'ultimo
+		uint first,
+			 last;
+		uint cost,
+			 load;
+
+		bool empty() const
+		{
+			return begin == end;
+		}
+	};
+
+	/**
+	 * Percorso di un veicolo visto come sequenza dei lati che serve, ognuno col suo verso.
+	 * Tra un servizio e il successivo il percorso tiene i lati di collegamento letti dalla soluzione,
+	 * mentre quelli creati concatenando tratti sono impliciti: il lato diretto del grafo completo,
+	 * che costa la distanza minima. Le somme prefisse di costo e carico permettono di valutare in
+	 * O( 1 ) ogni tratto, e quindi ogni mossa che ricompone i percorsi concatenando tratti.
+	 *
+	 * La conversione dalla Solution non perde informazioni: riportato sulla soluzione con apply,
+	 * il percorso letto ne riproduce esattamente il veicolo, e con esso toServicesSequence e toVertexSequence.
+	 */
+	class Route
+	{
+		private:
+			const model::Graph* graph;
+			uint depot;
+
+			std::vector<model::Edge*> services;
+			std::vector<uint> entries;
+			// Servizi percorsi anche da altri veicoli: spostarli cambierebbe il servente
+			std::vector<bool> shared;
+			// links[ i ]: lati che portano al servizio i ( dal deposito per il primo ),
+			//  links[ size() ]: lati che riportano al deposito
+			std::vector< std::vector<model::Edge*> > links;
+			std::vector<uint> linkCosts;
+
+			// costs[ i ] e loads[ i ]: costo e carico fino all'uscita del servizio i - 1
+			std::vector<uint> costs;
+			std::vector<uint> loads;
+
+			void update();
+
+		public:
+			Route( const model::Graph&, uint );
+			Route( const Solution&, uint, const model::Graph&, uint );
+
+			unsigned long size() const;
+
+			model::Edge* getService( int ) const;
+			uint getEntry( int ) const;
+			uint getExit( int ) const;
+			bool isShared( int ) const;
+
+			uint getCost() const;
+			uint getLoad() const;
+
+			Segment getSegment( int, int, bool = false ) const;
+			Segment getSegment( model::Edge*, uint ) const;
+			uint evaluate( const std::vector<Segment>& ) const;
+			Route assemble( const std::vector<Segment>& ) const;
+			Route orient() const;
+
+			void apply( Solution*, uint ) const;
+
+			std::string toServicesSequence() const;
+			std::string toVertexSequence() const;
+	};
+}
+
+#endif /* defined(__ucarpp__route__) */
@@ -29,7 +29,7 @@ M( M ), graph( graph ), compareGreedy( &this->graph )
 //		new ( &vehicles[ i ] ) Vehicle( i );
 	vehicles = vector<Vehicle*>();
 	for ( int i = 0; i < M; i++ )
-		vehicles.push_back( new Vehicle( i ) );
+		vehicles.push_back( new Vehicle( i, (uint)graph.getEdges().size() ) );
 }
 
 Solution::Solution( const Solution& source ):
@@ -39,7 +39,7 @@ compareGreedy( &this->graph )
 	vehicles = vector<Vehicle*>();
 	for ( int i = 0; i < M; i++ )
 	{
-		vehicles.push_back( new Vehicle( i ) );
+		vehicles.push_back( new Vehicle( i, (uint)source.vehicles[ i ]->getTraversed().size() ) );
 		for ( int j = 0; j < source.vehicles[ i ]->size(); j++ )
 		{
 			Edge* e = source.getEdge( i, j )->getEdge();
@@ -71,6 +71,12 @@ MetaEdge* Solution::getEdge( int vehicle, int index ) const
 	return vehicles[ vehicle ]->getEdge( index );
 }
 
+// Getter del metalato corrispondente ad un lato del grafo
+MetaEdge* Solution::getMetaEdge( const Edge* edge ) const
+{
+	return graph.getEdge( edge );
+}
+
 void Solution::addEdge( Edge* edge, int vehicle, int index )
 {
 	vehicles[ vehicle ]->addEdge( graph.getEdge( edge ), index );
@@ -137,6 +143,65 @@ uint Solution::getDemand( int vehicle ) const
 	return vehicles[ vehicle ]->getDemand();
 }
 
+/**
+ * Impronta della soluzione: percorsi dei veicoli e serventi dei lati profittevoli.
+ * È mantenuta incrementalmente da addEdge, removeEdge e setServer, per cui costa O( M ).
+ */
+fingerprint Solution::getHash() const
+{
+	fingerprint result = graph.getServerHash();
+	for ( Vehicle* vehicle : vehicles )
+		result += vehicle->getHash();
+
+	return result;
+}
+
+/**
+ * @return	i lati richiesti serviti da almeno un veicolo
+ */
+boost::dynamic_bitset<> Solution::getServed() const
+{
+	boost::dynamic_bitset<> result( vehicles.front()->getServed() );
+	for ( int i = 1; i < M; i++ )
+		result |= vehicles[ i ]->getServed();
+
+	return result;
+}
+
+/**
+ * @return	i lati percorsi da almeno un veicolo
+ */
+boost::dynamic_bitset<> Solution::getTraversed() const
+{
+	boost::dynamic_bitset<> result( vehicles.front()->getTraversed() );
+	for ( int i = 1; i < M; i++ )
+		result |= vehicles[ i ]->getTraversed();
+
+	return result;
+}
+
+/**
+ * @return	i lati percorsi da almeno due veicoli diversi
+ */
+boost::dynamic_bitset<> Solution::getShared() const
+{
+	boost::dynamic_bitset<> once( vehicles.front()->getTraversed() ),
+							twice( once.size() );
+	for ( int i = 1; i < M; i++ )
+	{
+		twice |= once & vehicles[ i ]->getTraversed();
+		once |= vehicles[ i ]->getTraversed();
+	}
+
+	return twice;
+}
+
+// Ritorna il numero di veicoli
+int Solution::getVehicles() const
+{
+	return M;
+}
+
 Vehicle* Solution::getVehicle( uint vehicle ) const
 {
 	return vehicles[ vehicle ];
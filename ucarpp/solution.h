@@ -35,6 +35,7 @@ namespace solver
 			~Solution();
 
 			MetaEdge* getEdge( int, int ) const;
+			MetaEdge* getMetaEdge( const model::Edge* ) const;
 			void addEdge( model::Edge*, int, int = -1 );
 			void removeEdge( int, int = -1 );
 
@@ -48,6 +49,14 @@ namespace solver
 			uint getDemand() const;
 			uint getDemand( int ) const;
 
+			fingerprint getHash() const;
+
+			// Insiemi di lati indicizzati con Edge::getId, ricavati da quelli dei veicoli
+			boost::dynamic_bitset<> getServed() const;
+			boost::dynamic_bitset<> getTraversed() const;
+			boost::dynamic_bitset<> getShared() const;
+
+			int getVehicles() const;
 			Vehicle* getVehicle( uint ) const;
 			uint getVehicleIndex( const Vehicle* ) const;
 
@@ -19,8 +19,12 @@ using namespace model;
 
 /*** Solver ***/
 
-Solver::Solver( Graph graph, uint depot, uint M, uint Q, uint tMax ):
-	graph( graph ), depot( depot ), M( M ), Q( Q ), tMax( tMax ),
+Solver::Solver( Graph graph, uint depot, uint M, uint Q, uint tMax, Parameters parameters ):
+	parameters( parameters ), graph( graph ), depot( depot ), M( M ), Q( Q ), tMax( tMax ),
+	bound( graph, depot, M, Q, tMax ),
+	elite( parameters.eliteSize ),
+	pool( parameters.routePool, this->graph, depot ),
+	visitedLookups( 0 ), visitedHits( 0 ),
 	currentSolution( createBaseSolution() ) {}
 
 Solution Solver::createBaseSolution()
@@ -28,189 +32,378 @@ Solution Solver::createBaseSolution()
 #ifdef DEBUG
 	cerr << endl << "Stampo la soluzione di base:" << endl;
 #endif
+	sortGreedyCandidates();
+	Solution baseSolution = createGreedySolution( 0, 0 );
+	
+#ifdef DEBUG
+	cerr << "Soluzione iniziale:\n" << baseSolution.toString() << endl;
+#endif
+	
+	return baseSolution;
+}
+
+/**
+ * Costruisce una soluzione estendendo a turno ogni veicolo col lato greedy migliore.
+ *
+ * @param alpha	Ampiezza della lista ristretta dei candidati, 0 per la scelta greedy.
+ * @param seed	Seme dei numeri casuali, usato solo se alpha > 0.
+ * @return		La soluzione costruita.
+ */
+Solution Solver::createGreedySolution( float alpha, uint seed )
+{
 	Solution baseSolution( M, graph );
 	
+	GreedyState state;
+	state.alpha = alpha;
+	state.seed = seed;
+	state.taken = vector<bool>( graph.getEdges().size(), false );
+	state.last = vector<uint>( M, depot );
+	state.time = vector<uint>( M, 0 );
+	state.load = vector<uint>( M, 0 );
+	state.filled = vector<bool>( M, false );
+	
 //	// Creazione sequenziale
 //	for ( int i = 0; i < M; i++ )
 //	{
 //#ifdef DEBUG
 //		cerr << "\tVeicolo " << i + 1 << endl;
 //#endif
-//		createBaseSolution( &baseSolution, i );
+//		while ( extendBaseSolution( &baseSolution, &state, i ) );
 //	}
 	
-	// Creazione parallela
+	// Creazione parallela: un lato per veicolo a turno, finché tutti sono pieni
 	int toBeFilled = M;
-	bool* filled = (bool*)calloc( M, sizeof( bool ) );
-	int* last = (int*)calloc( M, sizeof( int ) );
-	for ( int i = 0; i < M; i++ )
-		last[ i ] = depot;
-	
-	while ( ( toBeFilled -= extendBaseSolution( &baseSolution, M, filled, last ) ) > 0 );
-	
-#ifdef DEBUG
-	cerr << "Soluzione iniziale:\n" << baseSolution.toString() << endl;
-#endif
+	while ( toBeFilled > 0 )
+		for ( int i = 0; i < M; i++ )
+			if ( !state.filled[ i ] && !extendBaseSolution( &baseSolution, &state, i ) )
+				toBeFilled--;
 	
-	free( filled );
-	free( last );
 	return baseSolution;
 }
 
+/**
+ * Riempie in modo greedy un veicolo vuoto, tenendo conto dei lati già percorsi dagli altri.
+ *
+ * @param baseSolution	La soluzione da estendere.
+ * @param vehicle		Il veicolo da riempire.
+ */
 void Solver::createBaseSolution( Solution* baseSolution, int vehicle )
 {
-	uint currentNode = depot;
+	GreedyState state;
+	state.alpha = 0;
+	state.seed = 0;
+	state.taken = vector<bool>( graph.getEdges().size(), false );
+	for ( Edge* edge : graph.getEdges() )
+		state.taken[ edge->getId() ] = baseSolution->getMetaEdge( edge )->getTaken() > 0;
+	state.last = vector<uint>( M, depot );
+	state.time = vector<uint>( M, 0 );
+	state.load = vector<uint>( M, 0 );
+	state.filled = vector<bool>( M, false );
 	
-	// Aggiungo lati finché la soluzione è accettabile ed è possibile tornare al deposito
-	vector<Edge*> edges;
-	bool full = false;
-	while ( !full )
-	{
-		// Ordino i lati uscenti dal nodo corrente
-		edges = graph.getAdjList( currentNode );
-		sort( edges.begin(), edges.end(), baseSolution->compareGreedy );
-		
-		// Prendo il lato ammissibile migliore, se esiste
-		full = true;
-		for( Edge* edge : edges )
+	while ( extendBaseSolution( baseSolution, &state, vehicle ) );
+}
+
+/**
+ * Costruzione per risparmi ( Clarke e Wright ) adattata ai lati profittevoli.
+ * Ogni lato raggiungibile parte come giro a sé dal deposito; due giri vengono uniti, nei versi
+ * migliori, in ordine di tempo risparmiato più profitto tenuto insieme, convertito in tempo col
+ * rapporto tra durata e profitto dei giri iniziali, finché l'unione rispetta Q e tMax e restano
+ * più di M giri. I risparmi stanno in uno heap aggiornato pigramente: le voci che riguardano un
+ * giro modificato dopo il loro inserimento vengono scartate all'estrazione.
+ * Dei giri rimasti tengo gli M più profittevoli, che splitTour traduce in una soluzione.
+ *
+ * @return	la soluzione costruita ed ottimizzata
+ */
+Solution Solver::createSavingsSolution()
+{
+	struct Tour
+	{
+		// Indici in bound.getEdges(), primo ed ultimo nodo, tempo senza andata e ritorno
+		vector<int> genes;
+		uint first,
+			 last,
+			 inner,
+			 load,
+			 version;
+		float profit;
+		bool alive;
+	};
+
+	struct Saving
+	{
+		float saving;
+		float profit;
+		int a,
+			b;
+		bool reverseA,
+			 reverseB;
+		uint versionA,
+			 versionB;
+
+		bool operator< ( const Saving& other ) const
 		{
-			currentNode = edge->getDst( currentNode );
-			
-			// Aggiungo il lato selezionato e, in caso non sia tornato al deposito,
-			//  il lato necessario alla chiusura.
-			bool addedEdge = currentNode != depot;
-			baseSolution->addEdge( edge, vehicle );
-			if ( addedEdge )
-			{
-				Edge* returnEdge = graph.getEdge( currentNode, depot );
-				baseSolution->addEdge( returnEdge, vehicle );
-				
-#ifdef DEBUG
-				fprintf( stderr, "*** ADDED %d ***\n", currentNode );
-#endif
-			}
-			
-#ifdef DEBUG
-			cerr << "After added: " << baseSolution->toString( vehicle ) << endl;
-#endif
-			
-			/**
-			 * Se la soluzione resta feasible avendo preso
-			 * il lato selezionato ed il lato di ritorno,
-			 * accetto il nuovo lato e proseguo al successivo.
-			 */
-			if ( isFeasible( baseSolution, vehicle ) )
-			{
-#ifdef DEBUG
-				fprintf( stderr, "\t\tPreso %d (r: % 3.2f)\n\n",
-						currentNode + 1, edge->getProfitDemandRatio() );
-#endif
-				
-				if ( addedEdge )
-					baseSolution->removeEdge( vehicle );
-				
-				full = false;
-				break;
-			}
-			else
-			{
-				// Annullo la mossa
-				currentNode = edge->getDst( currentNode );
-				baseSolution->removeEdge( vehicle );
-				
-				if ( addedEdge )
-					baseSolution->removeEdge( vehicle );
-			}
+			if ( saving == other.saving )
+				return profit < other.profit;
+
+			return saving < other.saving;
+		}
+	};
+
+	const vector<Edge*>& required = bound.getEdges();
+	vector<Tour> tours;
+	for ( int i = 0; i < required.size(); i++ )
+		tours.push_back( { vector<int>( 1, i ), required[ i ]->getSrc(), required[ i ]->getDst(),
+						   required[ i ]->getCost(), required[ i ]->getDemand(), 0, required[ i ]->getProfit(), true } );
+
+	auto duration = [ & ]( const Tour& tour ) -> uint
+	{
+		return graph.getDistance( depot, tour.first ) + tour.inner + graph.getDistance( tour.last, depot );
+	};
+
+	// Peso del profitto: tempo di un giro iniziale per unità di profitto, in media
+	float totalDuration = 0,
+		  totalProfit = 0;
+	for ( const Tour& tour : tours )
+	{
+		totalDuration += duration( tour );
+		totalProfit += tour.profit;
+	}
+	float weight = totalDuration / max( totalProfit, 1.f );
+
+	// Unione di a e b, ognuno eventualmente invertito: gli altri versi danno gli stessi giri al contrario
+	priority_queue<Saving> heap;
+	auto push = [ & ]( int a, int b )
+	{
+		const Tour& tourA = tours[ a ];
+		const Tour& tourB = tours[ b ];
+		if ( tourA.load + tourB.load > Q )
+			return;
+
+		for ( int r = 0; r < 4; r++ )
+		{
+			bool reverseA = r & 1,
+				 reverseB = r & 2;
+			uint first = ( reverseA ? tourA.last : tourA.first ),
+				 x = ( reverseA ? tourA.first : tourA.last ),
+				 y = ( reverseB ? tourB.last : tourB.first ),
+				 last = ( reverseB ? tourB.first : tourB.last ),
+				 merged = graph.getDistance( depot, first ) + tourA.inner + graph.getDistance( x, y ) +
+						  tourB.inner + graph.getDistance( last, depot );
+
+			int saved = (int)( duration( tourA ) + duration( tourB ) ) - (int)merged;
+			if ( merged <= tMax )
+				heap.push( { saved + weight * ( tourA.profit + tourB.profit ), tourA.profit + tourB.profit,
+							 a, b, reverseA, reverseB, tourA.version, tourB.version } );
+		}
+	};
+
+	for ( int a = 0; a < tours.size(); a++ )
+		for ( int b = a + 1; b < tours.size(); b++ )
+			push( a, b );
+
+	int alive = (int)tours.size();
+	while ( alive > M && !heap.empty() )
+	{
+		Saving best = heap.top();
+		heap.pop();
+
+		Tour& tourA = tours[ best.a ];
+		Tour& tourB = tours[ best.b ];
+		if ( !tourA.alive || !tourB.alive || tourA.version != best.versionA || tourB.version != best.versionB )
+			continue;
+
+		if ( best.reverseA )
+		{
+			reverse( tourA.genes.begin(), tourA.genes.end() );
+			swap( tourA.first, tourA.last );
+		}
+		if ( best.reverseB )
+		{
+			reverse( tourB.genes.begin(), tourB.genes.end() );
+			swap( tourB.first, tourB.last );
 		}
+
+		tourA.genes.insert( tourA.genes.end(), tourB.genes.begin(), tourB.genes.end() );
+		tourA.inner += graph.getDistance( tourA.last, tourB.first ) + tourB.inner;
+		tourA.last = tourB.last;
+		tourA.load += tourB.load;
+		tourA.profit += tourB.profit;
+		tourA.version++;
+		tourB.alive = false;
+		alive--;
+
+		for ( int c = 0; c < tours.size(); c++ )
+			if ( c != best.a && tours[ c ].alive )
+				push( best.a, c );
 	}
+
+	// Tengo i giri più profittevoli ( a parità, i più brevi ) e li concateno in un giro gigante
+	vector<Tour*> kept;
+	for ( Tour& tour : tours )
+		if ( tour.alive )
+			kept.push_back( &tour );
+	sort( kept.begin(), kept.end(),
+		  [ & ]( const Tour* lhs, const Tour* rhs )
+		  {
+			  if ( lhs->profit == rhs->profit )
+				  return duration( *lhs ) < duration( *rhs );
+
+			  return lhs->profit > rhs->profit;
+		  } );
+
+	vector<int> giant;
+	for ( int i = 0; i < kept.size() && i < M; i++ )
+		giant.insert( giant.end(), kept[ i ]->genes.begin(), kept[ i ]->genes.end() );
+
+	Solution result = splitTour( giant );
+	optimizeSolution( &result );
+
+#ifdef DEBUG
+	cerr << "Soluzione per risparmi:\n" << result.toString() << endl;
+#endif
+	return result;
+}
+
+/**
+ * Ordina una volta per tutte i lati uscenti da ogni nodo, come farebbe compareGreedy
+ * su una soluzione vuota. Durante la costruzione un lato già percorso ha rapporto -1
+ * e va cercato tra quelli ordinati per costo.
+ */
+void Solver::sortGreedyCandidates()
+{
+	greedyByRatio = vector< vector<Edge*> >( graph.size() );
+	greedyByCost = vector< vector<Edge*> >( graph.size() );
 	
-	if ( currentNode != depot )
-		baseSolution->addEdge( graph.getEdge( currentNode, depot ), vehicle );
+	for ( uint u = 0; u < graph.size(); u++ )
+	{
+		greedyByCost[ u ] = graph.getAdjList( u );
+		sort( greedyByCost[ u ].begin(), greedyByCost[ u ].end(),
+			  []( const Edge* lhs, const Edge* rhs )
+			  {
+				  return lhs->getCost() > rhs->getCost();
+			  } );
+		
+		for ( Edge* edge : greedyByCost[ u ] )
+			if ( edge->getDemand() != 0 )
+				greedyByRatio[ u ].push_back( edge );
+		stable_sort( greedyByRatio[ u ].begin(), greedyByRatio[ u ].end(),
+					 []( const Edge* lhs, const Edge* rhs )
+					 {
+						 return lhs->getProfitDemandRatio() > rhs->getProfitDemandRatio();
+					 } );
+	}
 }
 
 /**
- * Funzione per creare una soluzione di base in parallelo su ogni veicolo.
+ * Sceglie il lato migliore con cui estendere un veicolo, nell'ordine di compareGreedy.
+ * L'ammissibilità del lato e del ritorno al deposito si verifica in tempo costante
+ * a partire dal tempo e dal carico accumulati.
+ * Con alpha > 0 il lato viene estratto tra quelli ammissibili il cui rapporto dista
+ * dal migliore al più alpha volte l'intervallo dei rapporti ( lista ristretta della GRASP ).
  *
- * @param baseSolution	La soluzione da estendere.
- * @param M				Il numero di veicoli.
- * @param filled		Vettore indicante quali veicoli sono già stati riempiti.
- * @param last			Vettore indicante il nodo finale di ogni veicolo.
- * @return				Numero di veicoli riempiti durante l'iterazione.
+ * @param state		Lo stato della costruzione.
+ * @param vehicle	Il veicolo da estendere.
+ * @return			Il lato scelto, NULL se il veicolo è pieno.
  */
-int Solver::extendBaseSolution( Solution* baseSolution, int M, bool* filled, int* last )
+Edge* Solver::pickGreedyEdge( GreedyState* state, uint vehicle ) const
 {
-	vector<Edge*> edges;
-	int filledCount = 0;
-	for ( int i = 0; i < M; i++ )
+	uint node = state->last[ vehicle ];
+	
+	auto fits = [&]( Edge* edge ) -> bool
 	{
-		// Ho già riempito il veicolo. Passo al successivo
-		if ( filled[ i ] )
-			continue;
-		
-		// Ordino i lati uscenti dal nodo corrente
-		edges = graph.getAdjList( last[ i ] );
-		sort( edges.begin(), edges.end(), baseSolution->compareGreedy );
+		uint next = edge->getDst( node ),
+			 demand = state->taken[ edge->getId() ] ? 0 : edge->getDemand();
 		
-		// Prendo il lato ammissibile migliore, se esiste
-		filled[ i ] = true;
-		for( Edge* edge : edges )
+		// Anche il lato di ritorno serve, se nessuno lo ha ancora percorso
+		if ( next != depot )
 		{
-			last[ i ] = edge->getDst( last[ i ] );
-			
-			// Aggiungo il lato selezionato ed il lato necessario alla chiusura.
-			bool addedEdge = last[ i ] != depot;
-			baseSolution->addEdge( edge, i );
-			if ( addedEdge )
-			{
-				Edge* returnEdge = graph.getEdge( last[ i ], depot );
-				baseSolution->addEdge( returnEdge, i );
-			}
-			
-#ifdef DEBUG
-			cerr << "After added: " << baseSolution->toString( i ) << endl;
-#endif
-			
-			/**
-			 * Se la soluzione resta feasible avendo preso
-			 * il lato selezionato ed il lato di ritorno,
-			 * accetto il nuovo lato.
-			 */
-			if ( isFeasible( baseSolution, i ) )
-			{
-#ifdef DEBUG
-				fprintf( stderr, "\t\tPreso %d (r: % 3.2f)\n\n",
-						last[ i ] + 1, edge->getProfitDemandRatio() );
-#endif
-				
-				if ( addedEdge )
-					baseSolution->removeEdge( i );
-				
-				filled[ i ] = false;
-				break;
-			}
-			else
-			{
-				// Annullo la mossa
-				last[ i ] = edge->getDst( last[ i ] );
-				
-				baseSolution->removeEdge( i );
-				if ( addedEdge )
-					baseSolution->removeEdge( i );
-			}
+			Edge* returnEdge = graph.getEdge( next, depot );
+			if ( returnEdge != edge && !state->taken[ returnEdge->getId() ] )
+				demand += returnEdge->getDemand();
 		}
 		
-		if ( filled[ i ] )
+		return state->time[ vehicle ] + edge->getCost() + graph.getDistance( next, depot ) <= tMax &&
+			   state->load[ vehicle ] + demand <= Q;
+	};
+	
+	if ( state->alpha > 0 )
+	{
+		vector< pair<float, Edge*> > feasible;
+		for ( Edge* edge : greedyByCost[ node ] )
+			if ( fits( edge ) )
+				feasible.push_back( make_pair( state->taken[ edge->getId() ] ? -1 : edge->getProfitDemandRatio(), edge ) );
+		
+		if ( feasible.empty() )
+			return NULL;
+		
+		float best = -1,
+			  worst = FLT_MAX;
+		for ( auto& candidate : feasible )
 		{
-			if ( last[ i ] != depot )
-			{
-				Edge* returnEdge = graph.getEdge( last[ i ], depot );
-				baseSolution->addEdge( returnEdge, i );
-			}
-			filledCount++;
+			best = max( best, candidate.first );
+			worst = min( worst, candidate.first );
 		}
+		
+		float threshold = best - state->alpha * ( best - worst );
+		vector<Edge*> restricted;
+		for ( auto& candidate : feasible )
+			if ( candidate.first >= threshold )
+				restricted.push_back( candidate.second );
+		
+		return restricted[ rand_r( &state->seed ) % restricted.size() ];
 	}
+	
+	// Prima i lati ancora da servire, per rapporto decrescente
+	for ( Edge* edge : greedyByRatio[ node ] )
+		if ( !state->taken[ edge->getId() ] && fits( edge ) )
+			return edge;
+	
+	// Poi tutti quelli con rapporto -1, per costo decrescente
+	for ( Edge* edge : greedyByCost[ node ] )
+		if ( ( state->taken[ edge->getId() ] || edge->getDemand() == 0 ) && fits( edge ) )
+			return edge;
+	
+	return NULL;
+}
 
-	return filledCount;
+/**
+ * Estende un veicolo col lato ammissibile migliore; se non ne esistono lo chiude.
+ *
+ * @param baseSolution	La soluzione da estendere.
+ * @param state			Lo stato della costruzione, aggiornato.
+ * @param vehicle		Il veicolo da estendere.
+ * @return				Falso, se il veicolo è stato riempito.
+ */
+bool Solver::extendBaseSolution( Solution* baseSolution, GreedyState* state, uint vehicle )
+{
+	uint& last = state->last[ vehicle ];
+	
+	Edge* edge = pickGreedyEdge( state, vehicle );
+	if ( edge == NULL )
+	{
+		if ( last != depot )
+			edge = graph.getEdge( last, depot );
+		state->filled[ vehicle ] = true;
+	}
+	
+	if ( edge != NULL )
+	{
+		baseSolution->addEdge( edge, vehicle );
+		if ( !state->taken[ edge->getId() ] )
+		{
+			state->taken[ edge->getId() ] = true;
+			state->load[ vehicle ] += edge->getDemand();
+		}
+		state->time[ vehicle ] += edge->getCost();
+		last = edge->getDst( last );
+		
+#ifdef DEBUG
+		fprintf( stderr, "\t\tPreso %d (r: % 3.2f)\n\n",
+				last + 1, edge->getProfitDemandRatio() );
+#endif
+	}
+	
+	return !state->filled[ vehicle ];
 }
 
 Solution Solver::justBellman()
@@ -242,694 +435,2463 @@ Solution Solver::justBellman()
 	return result;
 }
 
-Solution Solver::vnasd( int nIter, Solution baseSolution, int repetition )
+/**
+ * Risolve all'ottimo con un branch and bound parallelo, partendo dalla soluzione data
+ * come limite inferiore. Praticabile solo su istanze piccole: EXACT_NODES limita i nodi espansi.
+ *
+ * @param baseSolution	la soluzione ammissibile di partenza
+ * @return	la soluzione ottima, o la migliore trovata se il limite di nodi è stato raggiunto
+ */
+Solution Solver::exact( Solution baseSolution )
 {
-	float iterations = nIter / ( 2 * repetition );
-
-	for( int i = 0; i < repetition; i++ )
-	{
-		baseSolution = vns( ceil( iterations ), baseSolution );
-		baseSolution = vnd( floor( iterations ), baseSolution );
+	Exact branchAndBound( graph, bound, depot, M, Q, tMax, parameters.exactNodes, parameters.threads );
+	Solution result = branchAndBound.solve( baseSolution );
 
-		for ( int i = 0; i < M; i++ )
-			if ( !isFeasible( &baseSolution, i ) )
-				throw 2;
-	}
+	cerr << "Nodi espansi: " << branchAndBound.getNodes();
+	cerr << ( branchAndBound.isOptimal() ? ", ottimo dimostrato" : ", limite di nodi raggiunto: ottimo non dimostrato" ) << endl;
 
-	return baseSolution;
+	return result;
 }
 
-Solution Solver::vnaasd( int nIter, Solution baseSolution, int repetition )
+/**
+ * Tabu search: ad ogni iterazione valuta TABU_CANDIDATES mosse casuali ( apertura, chiusura,
+ * scambio di servente ) e si sposta sulla migliore non proibita, anche se peggiorativa.
+ * Le soluzioni visitate di recente sono proibite tramite la loro impronta, per cui riconoscere
+ * un ciclo costa O( 1 ); una soluzione proibita è ammessa se migliora l'ottimo ( aspirazione ).
+ *
+ * @param nIter			il numero di iterazioni
+ * @param baseSolution	la soluzione di partenza
+ * @return	la soluzione migliore trovata, ottimizzata
+ */
+Solution Solver::tabuSearch( int nIter, Solution baseSolution )
 {
-	float iterations = nIter / ( 4 * repetition );
+	// Inizializzo il generatore di numeri casuali
+	srand( (uint)time( NULL ) );
 
-	for( int i = 0; i < repetition; i++ )
+	Solution* optimalSolution = new Solution( baseSolution );
+
+	// Impronte proibite in ordine di inserimento, con il numero di occorrenze nella lista
+	deque<fingerprint> tabuList;
+	unordered_map<fingerprint, int> tabu;
+	tabuList.push_back( baseSolution.getHash() );
+	tabu[ tabuList.back() ]++;
+
+	if( output_file.is_open() )
 	{
-		baseSolution = vns( floor( 3 * iterations ), baseSolution );
+		printToFile( &baseSolution );
+		printToFile( optimalSolution );
+	}
 
-		baseSolution = vnd( ceil( iterations ), baseSolution );
+	while ( nIter-- > 0 )
+	{
+		if ( isGapClosed( optimalSolution ) )
+			break;
+
+		Solution* bestCandidate = NULL;
+		for ( int c = 0; c < parameters.tabuCandidates; c++ )
+		{
+			Solution candidate( baseSolution );
+			if ( !tabuMove( &candidate, rand() % M ) )
+				continue;
+
+			// Criterio di aspirazione: una mossa proibita è ammessa se porta ad un nuovo ottimo
+			if ( tabu.count( candidate.getHash() ) && !( candidate > *optimalSolution ) )
+				continue;
+
+			if ( bestCandidate == NULL || candidate > *bestCandidate )
+			{
+				delete bestCandidate;
+				bestCandidate = new Solution( candidate );
+			}
+		}
+
+		// Tutte le mosse sono fallite o proibite: riprovo all'iterazione successiva
+		if ( bestCandidate == NULL )
+			continue;
+
+		baseSolution = Solution( *bestCandidate );
+		delete bestCandidate;
+		elite.offer( baseSolution );
 
 		for ( int i = 0; i < M; i++ )
 			if ( !isFeasible( &baseSolution, i ) )
 				throw 2;
+
+		// Aggiorno la lista tabu, scartando l'impronta più vecchia
+		tabuList.push_back( baseSolution.getHash() );
+		tabu[ tabuList.back() ]++;
+		while ( tabuList.size() > parameters.tabuTenure )
+		{
+			if ( --tabu[ tabuList.front() ] <= 0 )
+				tabu.erase( tabuList.front() );
+			tabuList.pop_front();
+		}
+
+		if ( baseSolution > *optimalSolution )
+		{
+			delete optimalSolution;
+			optimalSolution = new Solution( baseSolution );
+			reportGap( optimalSolution );
+		}
+
+		if( output_file.is_open() )
+		{
+			printToFile( &baseSolution );
+			printToFile( optimalSolution );
+		}
 	}
 
-	return baseSolution;
+	// Ottimizzazione finale
+	optimizeSolution( optimalSolution );
+
+#ifdef DEBUG
+	cerr << "TS" << optimalSolution->toString();
+#endif
+	return *optimalSolution;
 }
 
-Solution Solver::vns( int nIter, Solution baseSolution )
+/**
+ * Adaptive Large Neighborhood Search: ad ogni iterazione distrugge parte della soluzione
+ * corrente e la ripara, scegliendo gli operatori con probabilità proporzionale ai loro pesi.
+ * Ogni ALNS_SEGMENT iterazioni i pesi vengono aggiornati in base ai punteggi ottenuti
+ * ( nuovo ottimo, miglioramento della corrente, soluzione accettata ).
+ * Le soluzioni non miglioranti vengono accettate secondo ALNS_ACCEPT ( di default simulated annealing ).
+ *
+ * Distruzioni:	0 tratto casuale ( openSolutionRandom ), 1 tratto di peggior profitto su costo,
+ *				2 tratti vicini ad un nodo casuale, 3 intero veicolo.
+ * Riparazioni:	0 chiusura di Bellman ( closeSolutionDijkstra ), 1 inserimento greedy,
+ *				2 inserimento col rimpianto-k ( REGRET_K ).
+ *
+ * @param nIter			il numero di iterazioni
+ * @param baseSolution	la soluzione di partenza
+ * @return	la soluzione migliore trovata, ottimizzata
+ */
+Solution Solver::alns( int nIter, Solution baseSolution )
 {
 	// Inizializzo il generatore di numeri casuali
 	srand( (uint)time( NULL ) );
-	int k = 1;
-	// Creo una copia della soluzione iniziale sulla quale applicare la vns
-	Solution shakedSolution = baseSolution;
+
 	Solution* optimalSolution = new Solution( baseSolution );
 
-	// Se richiesto, stampo i risultati su un file esterno
+	vector<float> destroyWeights( ALNS_DESTROYS, 1 ),
+				  repairWeights( ALNS_REPAIRS, 1 ),
+				  destroyScores( ALNS_DESTROYS, 0 ),
+				  repairScores( ALNS_REPAIRS, 0 );
+	vector<int> destroyUses( ALNS_DESTROYS, 0 ),
+				repairUses( ALNS_REPAIRS, 0 );
+
+	Acceptance acceptance( parameters.alnsAccept, parameters, baseSolution.getProfit(), bound.getUpperBound(), nIter );
+
 	if( output_file.is_open() )
 	{
-		printToFile( &shakedSolution );
 		printToFile( &baseSolution );
+		printToFile( optimalSolution );
 	}
-	
-	// Ciclo fino a quando la stopping rule me lo consente o prima se trovo una soluzione migliore di quella iniziale
-	while ( nIter-- > 0 )
+
+	for ( int iteration = 1; iteration <= nIter; iteration++ )
 	{
-		// Copio la soluzione di base su una soluzione che elaborerò nella vns
-		shakedSolution = Solution( baseSolution );
+		if ( isGapClosed( optimalSolution ) )
+			break;
 
-#ifdef DEBUG
-		cerr << "shakedSolution = Solution( baseSolution ): " << endl << "Base: " << baseSolution.toString() << "Shaked: " << shakedSolution.toString() << endl;
-#endif
+		int destroy = roulette( destroyWeights ),
+			repair = roulette( repairWeights );
 
-		
-		/*** Shaking ***/
-		// Estraggo un veicolo ed un lato iniziale casuali
-		// Tengo traccia anche dei nodi sorgente e destinazione di tale lato
-		uint vehicle = rand() % M;
+		Solution candidate( baseSolution );
+		vector<Hole> holes;
 
-#ifdef DEBUG
-		cerr << "VNS " << nIter << " sul veicolo " << vehicle << endl;
-#endif
+		/*** Distruzione e riparazione ***/
+		bool feasible = destroySolution( &candidate, destroy, 1 + rand() % parameters.kMax, &holes ) &&
+						repairSolution( &candidate, repair, holes );
 
-		// MrBean colpisce ancora
-		// Utile per essere sicuri di fare tutte le ottimizzazioni possibili
-		mrBeanBeanBinPacking( &shakedSolution, vehicle );
+		// Accorcio i percorsi modificati
+		for ( int i = 0; feasible && i < holes.size(); i++ )
+			cleanVehicle( &candidate, holes[ i ].vehicle );
 
-#ifdef DEBUG
-		cerr << "infra shake " << shakedSolution.toString();
-#endif
+		for ( int i = 0; feasible && i < M; i++ )
+			feasible = isFeasible( &candidate, i );
 
-		// Non mi interesso del valore di ritorno perché pressoché inutile. :D
-		mutateSolution( &shakedSolution, vehicle, ceil( XI * ( k + 1 ) ) );
+		// Percorro i servizi nei versi migliori
+		if ( feasible )
+			orientServices( &candidate );
 
-#ifdef DEBUG
-		cerr << "Soluzioni:" << endl;
-		cerr << "Base: " << baseSolution.toString();
-		cerr << "Shaked: " << shakedSolution.toString();
-		cerr << "Optimal: " << optimalSolution->toString();
-#endif
-		
-		/*** Ricerca locale ***/
-		// Adottiamo il criterio di best improvement e non first.
-		// Per prima cosa dobbiamo copiare la soluzione corrente in una temporanea che indicherà la soluzione con massimo profitto trovato.
-		Solution maxSolution = Solution( baseSolution );
-		Solution localSearchSolution( shakedSolution );
-
-		for ( int v = 0; v < M; v++ )
+		/*** Move or not ***/
+		int score = 0;
+		if ( feasible )
 		{
-			// Cerco di ottimizzare il veicolo appena shakerato
-			localSearchSolution = Solution( shakedSolution );
-			mrBeanBeanBinPacking( &localSearchSolution, v );
-			cleanVehicle( &localSearchSolution, v );
-
-#ifdef DEBUG
-			cerr << "Ricerco localmente su " << v << ": " << localSearchSolution.toString( v );
-#endif
-
-			uint previous = depot;
-			uint next;
-			for ( int i = 0; i < localSearchSolution.size( v ); i++ )
+			if ( candidate > *optimalSolution )
 			{
-#ifdef DEBUG
-				cerr << "Lavoro sul veicolo " << v << " lato " << i;
-				cerr << " ( " << localSearchSolution.getEdge( v, i )->getSrc() << " " << localSearchSolution.getEdge( v, i )->getDst() << " ) " << endl;
-				cerr << "Parto da: " << localSearchSolution.toString();
-#endif
-				// Elimino almeno un lato
-				list <Edge*> removedEdges;
-				bool wasServer;
-
-				Vehicle* tempVehicle = localSearchSolution.getVehicle( v );
-				
-				MetaEdge* tempMeta = localSearchSolution.getEdge( v, i );
-				wasServer = tempMeta->isServer( tempVehicle );
-				// Pro thinking:
-				// Se MrBean non è riuscito a riassegnare questo lato ad altri veicoli ed io non sono l'unico che lo attraversa,
-				// è inutile cercare di toglierlo dalla soluzione in quanto renderebbe infeasible un altro veicolo, per cui salto.
-				if( !isRemovable( &localSearchSolution, v, i ) )
-				{
-#ifdef DEBUG
-					cerr << "Il lato " << i << " non è rimovibile. Passo al lato successivo." << endl;
-#endif
-					previous = tempMeta->getDst( previous );
-					continue;
-				}
+				delete optimalSolution;
+				optimalSolution = new Solution( candidate );
+				reportGap( optimalSolution );
+				score = ALNS_SCORE_BEST;
+			}
+			else if ( candidate > baseSolution )
+				score = ALNS_SCORE_BETTER;
+			else if ( acceptance.accept( candidate, baseSolution, *optimalSolution ) )
+				score = ALNS_SCORE_ACCEPTED;
 
-				removedEdges.push_back( tempMeta->getEdge() );
+			if ( score > 0 )
+			{
+				baseSolution = Solution( candidate );
+				elite.offer( baseSolution );
+			}
+		}
 
-				localSearchSolution.removeEdge( v, i );
-				next = tempMeta->getDst( previous );
+		destroyScores[ destroy ] += score;
+		destroyUses[ destroy ]++;
+		repairScores[ repair ] += score;
+		repairUses[ repair ]++;
 
-				// Elimino lati dalla soluzione fintanto che questi non ne aumentano il profitto e fintanto che sono presenti nella soluzione
-				while( i < localSearchSolution.size( v ) && isRemovable( &localSearchSolution, v, i ) )
-				{
-					// Calcolo la differenza di profitto che abbiamo nel togliere un lato alla soluzione
-					int diffProfit = localSearchSolution.getProfit( v );
+		// Fine del segmento: i pesi si spostano verso il punteggio medio degli operatori usati
+		if ( iteration % parameters.alnsSegment == 0 )
+		{
+			for ( int i = 0; i < ALNS_DESTROYS; i++ )
+				if ( destroyUses[ i ] )
+					destroyWeights[ i ] = ( 1 - parameters.alnsReaction ) * destroyWeights[ i ] +
+										  parameters.alnsReaction * destroyScores[ i ] / destroyUses[ i ];
+			for ( int i = 0; i < ALNS_REPAIRS; i++ )
+				if ( repairUses[ i ] )
+					repairWeights[ i ] = ( 1 - parameters.alnsReaction ) * repairWeights[ i ] +
+										 parameters.alnsReaction * repairScores[ i ] / repairUses[ i ];
+
+			fill( destroyScores.begin(), destroyScores.end(), 0 );
+			fill( repairScores.begin(), repairScores.end(), 0 );
+			fill( destroyUses.begin(), destroyUses.end(), 0 );
+			fill( repairUses.begin(), repairUses.end(), 0 );
+		}
 
-					// Rimuovo il lato i
-					MetaEdge* temp = localSearchSolution.getEdge( v, i );
-					localSearchSolution.removeEdge( v, i );
+		acceptance.update( baseSolution );
 
-					diffProfit -= localSearchSolution.getProfit( v );
+		if( output_file.is_open() )
+		{
+			printToFile( &candidate );
+			printToFile( &baseSolution );
+		}
+	}
 
-					// Se non ho differenze di profitto, tolgo quel lato dalla soluzione
-					if( diffProfit == 0 )
-					{
-						// Sposto il nodo di partenza
-						next = temp->getDst( next );
-						// Inserisco il lato tolto nella lista
-						removedEdges.push_back( temp->getEdge() );
-					}
-					else
-					{
-						// Altrimenti lo riaggiungo
-						localSearchSolution.addEdge( temp->getEdge(), v, i );
-						//temp->setServer( tempVehicle );
-						break;
-					}
+	cerr << "Pesi distruzione:";
+	for ( float weight : destroyWeights )
+		cerr << " " << weight;
+	cerr << ", riparazione:";
+	for ( float weight : repairWeights )
+		cerr << " " << weight;
+	cerr << endl;
 
-				}
+	// Ottimizzazione finale
+	optimizeSolution( optimalSolution );
 
 #ifdef DEBUG
-				cerr << "Creato un buco di " << removedEdges.size() << " lati su ( " << previous << " " << next << " ) " << endl;
-				cerr << "Cristo: " << localSearchSolution.toString() << endl;
+	cerr << "ALNS" << optimalSolution->toString();
 #endif
+	return *optimalSolution;
+}
 
-				// Chiedo a Dijkstra di calcolarmi la chiusura migliore
-				list<Edge*> closure = closeSolutionDijkstra( localSearchSolution, v, previous, next, i );
-				previous = next;
+/**
+ * Algoritmo memetico: ogni individuo è un giro gigante sui lati profittevoli raggiungibili,
+ * che splitTour taglia in al più M percorsi. Ad ogni generazione nascono POPULATION figli
+ * ( torneo binario, incrocio OX, scambio di due geni con probabilità MUTATION ), che vengono
+ * decodificati ed ottimizzati in parallelo con optimizeSolution; il giro di ogni figlio viene
+ * poi riscritto secondo la soluzione ottimizzata. Sopravvivono i POPULATION individui migliori
+ * tra genitori e figli, senza doppioni.
+ *
+ * @param nIter			il numero di generazioni
+ * @param baseSolution	la soluzione di partenza, inserita nella popolazione iniziale
+ * @return	la soluzione migliore trovata
+ */
+Solution Solver::memetic( int nIter, Solution baseSolution )
+{
+	// Inizializzo il generatore di numeri casuali
+	srand( (uint)time( NULL ) );
 
-				if ( !closure.size() )
-				{
-					// Quell'incapace del Sig. Bellman-Ford-Zucchelli ha fallito: ripristino.
-					for( auto it = removedEdges.rbegin(); it != removedEdges.rend(); ++it )
-						localSearchSolution.addEdge( *it, v, i );
-	
-					if( wasServer )
-					{
-#ifdef DEBUG
-						cerr << "PIPPIRIPACCHIO1 questa variabile è utile" << endl;
-#endif
-						localSearchSolution.getEdge( v, i )->setServer( tempVehicle );
-					}
+	struct Individual
+	{
+		vector<int> tour;
+		Solution* solution;
+	};
+
+	int genes = (int)bound.getEdges().size();
+	vector<int> identity( genes );
+	for ( int i = 0; i < genes; i++ )
+		identity[ i ] = i;
+
+	// Popolazione iniziale: la soluzione di partenza ed individui casuali
+	vector< vector<int> > tours( 1, encodeTour( baseSolution, identity ) );
+	while ( tours.size() < parameters.population )
+	{
+		tours.push_back( identity );
+		random_shuffle( tours.back().begin(), tours.back().end() );
+	}
 
-					i += removedEdges.size() - 1;
-					continue;
-				}
+	vector<Individual> population;
+	vector<Solution*> solutions = evaluateTours( tours );
+	for ( int i = 0; i < tours.size(); i++ )
+		population.push_back( { encodeTour( *solutions[ i ], tours[ i ] ), solutions[ i ] } );
 
-				// Se questo porta un miglioramento, effettuo la chiusura, altrimenti riaggiungo il lato i
-				for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
-					localSearchSolution.addEdge( *it, v, i );
+	Solution* optimalSolution = new Solution( baseSolution );
 
-#ifdef DEBUG
-				cerr << "Soluzioni dopo ricerca locale: " << localSearchSolution.toString() << endl;
-#endif
+	if( output_file.is_open() )
+	{
+		printToFile( &baseSolution );
+		printToFile( optimalSolution );
+	}
 
-				// Controllo se ho trovato una soluzione migliore della massima trovata in precedenza
-				if ( localSearchSolution > maxSolution )
-				{
-#ifdef DEBUG
-					cerr << "Migliorato" << endl;
-#endif
-					maxSolution = Solution( localSearchSolution );
-					// SFANCULATI break; // SFANCULATI BEST
-				}
+	while ( nIter-- > 0 )
+	{
+		if ( isGapClosed( optimalSolution ) )
+			break;
 
-				// Resetto la shakedSolution per effettuare una nuova ricerca
-				for( int j = 0; j < closure.size(); j++ )
-					localSearchSolution.removeEdge( v, i );
+		// Generazione dei figli
+		tours.clear();
+		for ( int c = 0; c < parameters.population; c++ )
+		{
+			int parents[ 2 ];
+			for ( int p = 0; p < 2; p++ )
+			{
+				int a = rand() % population.size(),
+					b = rand() % population.size();
+				parents[ p ] = ( *population[ b ].solution > *population[ a ].solution ? b : a );
+			}
 
-				for( auto it = removedEdges.rbegin(); it != removedEdges.rend(); ++it )
-					localSearchSolution.addEdge( *it, v, i );
+			tours.push_back( crossTours( population[ parents[ 0 ] ].tour, population[ parents[ 1 ] ].tour ) );
 
-//				if( wasServer )
-//				{
-//#ifdef DEBUG
-//					cerr << "PIPPIRIPACCHIO2 questa variabile è utile" << endl;
-//#endif
-//					localSearchSolution.getEdge( v, i )->setServer( tempVehicle );
-//				}
+			if ( genes > 1 && (float)rand() / RAND_MAX < parameters.mutation )
+				swap( tours.back()[ rand() % genes ], tours.back()[ rand() % genes ] );
+		}
 
-#ifdef DEBUG
-				cerr << "Fine ciclo: ripristinata la shakedSolution iniziale?" << endl;
-				cerr << "Shaked: " << localSearchSolution.toString() << endl;
-#endif
+		solutions = evaluateTours( tours );
+		for ( int i = 0; i < tours.size(); i++ )
+			population.push_back( { encodeTour( *solutions[ i ], tours[ i ] ), solutions[ i ] } );
 
-				i += removedEdges.size() - 1;
-			}
+		// Sopravvivenza dei migliori, scartando le soluzioni con la stessa impronta
+		sort( population.begin(), population.end(),
+			  []( const Individual& lhs, const Individual& rhs )
+			  {
+				  return *lhs.solution > *rhs.solution;
+			  } );
+
+		set<fingerprint> seen;
+		vector<Individual> survivors;
+		for ( Individual& individual : population )
+		{
+			if ( survivors.size() < parameters.population && seen.insert( individual.solution->getHash() ).second )
+				survivors.push_back( individual );
+			else
+				delete individual.solution;
 		}
-		
-		
-		/*** Move or not ***/
-		// Soluzione migliore: maggior profitto o stesso profitto con minori risorse
-		// Aggiorno la soluzione con quella più profittevole => mi sposto
-		if ( maxSolution > baseSolution )
+		population = survivors;
+
+		for ( Individual& individual : population )
+			elite.offer( *individual.solution );
+
+		if ( *population.front().solution > *optimalSolution )
 		{
-#ifdef DEBUG
-			cerr << "Soluzione migliorata: " << baseSolution.getProfit() << " => " << maxSolution.getProfit() << endl;
-#endif
-			// La prendo come soluzione ottima se il miglioramento è assoluto
-			if ( maxSolution > *optimalSolution )
-			{
-#ifdef DEBUG
-				cerr << "Nuovo massimo: " << optimalSolution->getProfit() << " => " << maxSolution.getProfit() << endl;
-#endif
-				// Cancello l'oggetto per liberare memoria e poi lo ricreo
-				delete optimalSolution;
-				optimalSolution = new Solution( maxSolution );
-			}
-			
-			// Salvo la nuova soluzione come soluzione di base per i cicli successivi
-			baseSolution = maxSolution;
-			
-			k = 0;
+			delete optimalSolution;
+			optimalSolution = new Solution( *population.front().solution );
+			reportGap( optimalSolution );
 		}
 
-		// Come all'inizio, se richiesto stampo su file i risultati
 		if( output_file.is_open() )
 		{
-			printToFile( &shakedSolution );
-			printToFile( &baseSolution );
+			printToFile( population.back().solution );
+			printToFile( optimalSolution );
 		}
-
-		for ( int i = 0; i < M; i++ )
-			if ( !isFeasible( &shakedSolution, i ) )
-				throw 2;
-
-		// Incremento il numero di iterazioni svolte
-		k = 1 + k % K_MAX;
 	}
-	
-	// Ottimizzazione finale
-	optimizeSolution( optimalSolution );
-	
+
 #ifdef DEBUG
-	cerr << "VNS" << optimalSolution->toString();
+	cerr << "MA" << optimalSolution->toString();
 #endif
 	return *optimalSolution;
 }
 
-Solution Solver::vnd( int nIter, Solution baseSolution )
+/**
+ * GRASP: costruzioni greedy randomizzate con la lista ristretta dei candidati,
+ * ognuna seguita da optimizeSolution, distribuite tra THREADS thread.
+ *
+ * @param nIter			il numero di costruzioni
+ * @param baseSolution	la soluzione di partenza
+ * @return	la migliore tra la soluzione di partenza e quelle costruite
+ */
+Solution Solver::grasp( int nIter, Solution baseSolution )
 {
-	// Inizializzo il generatore di numeri casuali
-	srand( (uint)time( NULL ) );
-	int k = 1;
-	// Creo una copia della soluzione iniziale sulla quale applicare la vns
-	Solution shakedSolution = baseSolution;
+	vector<Solution*> solutions( max( 0, nIter ), NULL );
+	int threads = ( parameters.threads > 0 ? parameters.threads : max( 1, (int)thread::hardware_concurrency() ) );
+	uint seed = (uint)time( NULL );
+
+	// Ogni costruzione ha il proprio seme, per non condividere il generatore tra i thread
+	auto work = [ & ]( int worker )
+	{
+		for ( int i = worker; i < solutions.size(); i += threads )
+		{
+			Solution solution = createGreedySolution( parameters.graspAlpha, seed + i );
+			optimizeSolution( &solution );
+			solutions[ i ] = new Solution( solution );
+		}
+	};
+
+	vector<thread> workers;
+	for ( int i = 1; i < threads; i++ )
+		workers.push_back( thread( work, i ) );
+	work( 0 );
+	for ( auto& worker : workers )
+		worker.join();
+
 	Solution* optimalSolution = new Solution( baseSolution );
-	
-	// Se richiesto, stampo i risultati su un file esterno
+
 	if( output_file.is_open() )
-	{
-		printToFile( &shakedSolution );
 		printToFile( &baseSolution );
-	}
 
-	// Ciclo fino a quando la stopping rule me lo consente o prima se trovo una soluzione migliore di quella iniziale
-	while ( nIter-- > 0 )
+	for ( Solution* solution : solutions )
 	{
-		shakedSolution = Solution( baseSolution );
-		
-		/*** Shaking ***/
-		// Estraggo un veicolo ed un lato iniziale casuali
-		// Tengo traccia anche dei nodi sorgente e destinazione di tale lato
-		uint vehicle = rand() % M,
-			 src,
-			 dst;
-		int	 edge = -1;
-
-#ifdef DEBUG
-		cerr << "VND " << nIter << " su " << vehicle << endl;
-#endif
-
-		// Prima di generare un buco nella soluzione, la muto, così da partire da
-		// una soluzione diversa ad ogni ciclo, e non sempre dalla stessa.
-		mutateSolution( &shakedSolution, vehicle, ceil( k ) );
+		elite.offer( *solution );
 
-		// Verifico che il buco sia stato creato correttamente
-		try
+		if ( *solution > *optimalSolution )
 		{
-			edge = openSolutionRandom( &shakedSolution, vehicle, k, &src, &dst );
-			if ( edge < 0 || edge >= shakedSolution.size() )
-				throw 10;
+			delete optimalSolution;
+			optimalSolution = new Solution( *solution );
+			reportGap( optimalSolution );
 		}
-		catch( int e )
+
+		if( output_file.is_open() )
 		{
-#ifdef DEBUG
-			cerr << "Open fallita " << e << endl;
-#endif
-			continue;
+			printToFile( solution );
+			printToFile( optimalSolution );
 		}
-		
+
+		delete solution;
+	}
+
 #ifdef DEBUG
-		cerr << shakedSolution.toString();
-		cerr << "Buco " << src << " " << dst << "\tindice " << edge << endl;
+	cerr << "GRASP" << optimalSolution->toString();
 #endif
-		
-		// Cerco di ottimizzare il veicolo appena shakerato
-		mrBeanBeanBinPacking( &shakedSolution, vehicle );
+	return *optimalSolution;
+}
 
-		list<Edge*> closure = closeSolutionDijkstra( shakedSolution, vehicle, src, dst, edge );
-		if ( !closure.size() )
-		{
-#ifdef DEBUG
-			cerr << "Pippero." << endl;
-#endif
-			continue;
-		}
+/**
+ * Ricombina i percorsi del pool con un set packing ed ottimizza la soluzione ottenuta.
+ *
+ * @param baseSolution	la soluzione migliore trovata finora
+ * @return	la ricombinazione, se è ammissibile e migliore di baseSolution; baseSolution altrimenti
+ */
+Solution Solver::recombineRoutes( Solution baseSolution )
+{
+	if ( !pool.size() )
+		return baseSolution;
 
-		for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
-			shakedSolution.addEdge( *it, vehicle, edge );
+	// Un collegamento può servire un lato che nessun percorso scelto serve più: controllo il carico
+	Solution packed = pool.recombine( M );
+	for ( int v = 0; v < M; v++ )
+		if ( !isFeasible( &packed, v ) )
+			return baseSolution;
 
-/*
-		// Ottimizzo la soluzione
-		optimizeSolution( &shakedSolution );
-*/
-		
-#ifdef DEBUG
-		cerr << "Soluzioni:" << endl;
-		cerr << "Base: " << baseSolution.toString();
-		cerr << "Shaked: " << shakedSolution.toString();
-		cerr << "Optimal: " << optimalSolution->toString();
-#endif
-		
-		/*** Move or not ***/
-		// Soluzione migliore: maggior profitto o stesso profitto con minori risorse
-		// Aggiorno la soluzione con quella più profittevole => mi sposto
-		if ( shakedSolution > baseSolution )
+	optimizeSolution( &packed );
+	elite.offer( packed );
+
+	if ( packed > baseSolution )
+		return packed;
+
+	return baseSolution;
+}
+
+/**
+ * Path relinking tra le coppie di soluzioni del pool d'élite.
+ * Ogni percorso parte dalla migliore delle due e si avvicina all'altra un lato servito alla volta;
+ * la miglior soluzione intermedia viene ottimizzata e riproposta al pool.
+ *
+ * @param baseSolution	la soluzione migliore trovata dalla ricerca
+ * @return	la soluzione migliore tra quella data e quelle trovate lungo i percorsi
+ */
+Solution Solver::pathRelinking( Solution baseSolution )
+{
+	elite.offer( baseSolution );
+	Solution* optimalSolution = new Solution( baseSolution );
+
+	// Il pool cambia durante i percorsi: lavoro su una sua copia
+	vector<Solution> snapshot;
+	for ( int i = 0; i < elite.size(); i++ )
+		snapshot.push_back( Solution( elite.getSolution( i ) ) );
+
+	for ( int i = 0; i < snapshot.size(); i++ )
+		for ( int j = i + 1; j < snapshot.size(); j++ )
 		{
-#ifdef DEBUG
-			cerr << "Soluzione migliorata: " << baseSolution.getProfit() << " => " << shakedSolution.getProfit() << endl;
-#endif
-			if ( shakedSolution > *optimalSolution )
+			if ( isGapClosed( optimalSolution ) )
+				break;
+
+			Solution relinked = ( snapshot[ j ] > snapshot[ i ] ? relink( snapshot[ j ], snapshot[ i ] ) : relink( snapshot[ i ], snapshot[ j ] ) );
+			optimizeSolution( &relinked );
+			elite.offer( relinked );
+
+			if ( relinked > *optimalSolution )
 			{
-#ifdef DEBUG
-				cerr << "Nuovo massimo: " << optimalSolution->getProfit() << " => " << shakedSolution.getProfit() << endl;
-#endif
-				optimalSolution = new Solution( shakedSolution );
+				delete optimalSolution;
+				optimalSolution = new Solution( relinked );
+				reportGap( optimalSolution );
+			}
+
+			if( output_file.is_open() )
+			{
+				printToFile( &relinked );
+				printToFile( optimalSolution );
 			}
-			
-			baseSolution = shakedSolution;
-			
-			k = 0;
 		}
 
-		// Come all'inizio, se richiesto stampo su file i risultati
-		if( output_file.is_open() )
+	return *optimalSolution;
+}
+
+/**
+ * Percorso tra due soluzioni: ad ogni passo applica, tra le differenze di lati serviti rimaste,
+ * quella che porta alla soluzione migliore, e ripulisce i veicoli modificati.
+ *
+ * @param from	la soluzione di partenza
+ * @param to	la soluzione guida
+ * @return	la miglior soluzione intermedia, from se non ce ne sono di ammissibili
+ */
+Solution Solver::relink( const Solution& from, const Solution& to )
+{
+	boost::dynamic_bitset<> source = from.getServed(),
+							target = to.getServed();
+
+	// Lati da aggiungere ( serviti solo dalla guida ) e da togliere ( serviti solo dalla partenza )
+	const vector<Edge*>& all = graph.getEdges();
+	vector< pair<Edge*, bool> > moves;
+	boost::dynamic_bitset<> difference = source ^ target;
+	for ( size_t i = difference.find_first(); i != boost::dynamic_bitset<>::npos; i = difference.find_next( i ) )
+		moves.push_back( make_pair( all[ i ], target[ i ] ) );
+
+	Solution current( from );
+	Solution* best = NULL;
+
+	// L'ultimo passo porterebbe ( al più ) alla guida stessa
+	while ( moves.size() > 1 )
+	{
+		Solution* bestStep = NULL;
+		int bestMove = -1;
+		for ( int m = 0; m < moves.size(); m++ )
 		{
-			printToFile( &shakedSolution );
-			printToFile( &baseSolution );
-		}
+			Solution step( current );
+			if ( !relinkMove( &step, moves[ m ].first, moves[ m ].second ) )
+				continue;
 
-		for ( int i = 0; i < M; i++ )
-			if ( !isFeasible( &shakedSolution, i ) )
+			if ( bestStep == NULL || step > *bestStep )
 			{
-#ifdef DEBUG
-				cerr << "Esco per unfeasability di " << i << endl;
-#endif
-				throw 2;
+				delete bestStep;
+				bestStep = new Solution( step );
+				bestMove = m;
 			}
+		}
+
+		if ( bestStep == NULL )
+			break;
 
-		k = 1 + k % K_MAX;
+		current = Solution( *bestStep );
+		delete bestStep;
+		moves.erase( moves.begin() + bestMove );
+
+		if ( best == NULL || current > *best )
+		{
+			delete best;
+			best = new Solution( current );
+		}
 	}
-	
-	// Ottimizzazione finale
-	optimizeSolution( optimalSolution );
-	
-#ifdef DEBUG
-	cerr << "VND" << optimalSolution->toString();
-#endif
-	return *optimalSolution;
+
+	return ( best != NULL ? *best : from );
 }
 
-uint Solver::mutateSolution( Solution *solution, uint vehicle, int k )
+/**
+ * Aggiunge un lato profittevole nella posizione più conveniente, oppure lo toglie da tutti i veicoli
+ * che lo percorrono chiudendo i buchi col collegamento diretto; i veicoli modificati vengono ripuliti.
+ *
+ * @param solution	la soluzione da modificare
+ * @param edge		il lato
+ * @param add		vero per aggiungerlo, falso per toglierlo
+ * @return	vero, se la mossa è riuscita e la soluzione è ammissibile
+ */
+bool Solver::relinkMove( Solution* solution, Edge* edge, bool add )
 {
-	// Inizializzo la funzione random
-	srand( (uint)time( NULL ) );
+	vector<bool> touched( M, false );
 
-	// Se il veicolo e` vuoto, lo genero e poi lo muto
-	// ( teoricamente meglio greedy, ma... )
-	if ( !solution->size( vehicle ) )
+	if ( add )
 	{
-		list<Edge*> closure = closeSolutionDijkstra( *solution, vehicle, depot, depot, 0 );
-		
-		if ( !closure.size() )
+		// Lato già raccolto da un passo precedente
+		if ( solution->getMetaEdge( edge )->getTaken() > 0 )
+			return false;
+
+		insertProfitable( solution, 0, vector<Edge*>( 1, edge ) );
+		if ( !solution->getMetaEdge( edge )->getTaken() )
+			return false;
+
+		for ( const Vehicle* taker : solution->getMetaEdge( edge )->getTakers() )
+			touched[ solution->getVehicleIndex( taker ) ] = true;
+	}
+	else
+	{
+		// Il servente può essere tolto solo quando gli altri non passano più dal lato:
+		//  ripeto finché tolgo qualcosa, al più una volta per veicolo
+		bool removed = true;
+		for ( int pass = 0; removed && pass < M && solution->getMetaEdge( edge )->getTaken() > 0; pass++ )
 		{
-			// Non esiste modo di chiudere il veicolo. È inutile fare altro.
-			return 0;
+			removed = false;
+			for ( int v = 0; v < M; v++ )
+				for ( int i = (int)solution->size( v ) - 1; i >= 0; i-- )
+				{
+					if ( i >= solution->size( v ) || solution->getEdge( v, i )->getEdge() != edge )
+						continue;
+
+					// Tolgo anche un lato adiacente, altrimenti il collegamento diretto sarebbe il lato stesso
+					int start = ( i + 1 < solution->size( v ) || i == 0 ? i : i - 1 );
+					vector<Hole> holes;
+					if ( !removeSegment( solution, v, start, 2, &holes ) )
+						continue;
+
+					Edge* closure = ( holes[ 0 ].src != holes[ 0 ].dst ? graph.getEdge( holes[ 0 ].src, holes[ 0 ].dst ) : NULL );
+					if ( closure == edge || !closeHole( solution, holes[ 0 ], false ) )
+						return false;
+
+					touched[ v ] = removed = true;
+				}
 		}
-		
-		for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
-			solution->addEdge( *it, vehicle, 0 );
+
+		if ( solution->getMetaEdge( edge )->getTaken() > 0 )
+			return false;
 	}
 
-	// Barbatrucco: puntatore a funzioni per essere più efficienti nella scrittura del codice.
-	// Definisco un puntatore alle funzioni usate per aprire o chiudere la soluzione corrente.
-	// Questo verrà istanziato a seconda della casualità ad una delle due funzioni.
-	bool (solver::Solver::* ninjaTurtle)( Solution*, uint, int );
+	for ( int v = 0; v < M; v++ )
+		if ( touched[ v ] )
+		{
+			cleanVehicle( solution, v );
+			if ( !isFeasible( solution, v ) )
+				return false;
+		}
 
-	// Devo modificare la soluzione passatami per k volte
-	// Ciclo sul numero di volte calcolato
-	for( int i = 0; i < k; i++ )
+	return true;
+}
+
+Solution Solver::vnasd( int nIter, Solution baseSolution, int repetition )
+{
+	float iterations = nIter / ( 2 * repetition );
+
+	for( int i = 0; i < repetition; i++ )
 	{
-		// Scelgo un lato sul quale operare
-		int edge = rand() % solution->size( vehicle );
+		baseSolution = vns( ceil( iterations ), baseSolution );
+		baseSolution = vnd( floor( iterations ), baseSolution );
 
-		// Casualmente scelgo se aprire o chiudere un lato
-		// Non mi interesso del valore di ritorno delle funzioni usate perchè so già dove il buco è stato creato, essendo io a passarlo come parametro.
-		float x = ( (float)( solution->getDemand( vehicle ) / Q + solution->getCost( vehicle ) / tMax ) / 2 );
-		x -= .75;
-		/* funzioni di pesatura */
-		// Arcotangente
-		//float p_close = atan( 50 * x ) / M_PI + .5;
+		for ( int i = 0; i < M; i++ )
+			if ( !isFeasible( &baseSolution, i ) )
+				throw 2;
+	}
 
-		// Tangente iperbolica
-		//float p_close = tanh( 15 * x ) + .5;
+	return baseSolution;
+}
 
-		// Funzione errore
-		//float p_close = erf( 10 * x ) + .5;
+Solution Solver::vnaasd( int nIter, Solution baseSolution, int repetition )
+{
+	float iterations = nIter / ( 4 * repetition );
 
-		// Funzione x / sqrt( 1 + x^2 )
-		float p_close = 7.5 * x / sqrt( 225 * x * x  + 1 );
+	for( int i = 0; i < repetition; i++ )
+	{
+		baseSolution = vns( floor( 3 * iterations ), baseSolution );
 
+		baseSolution = vnd( ceil( iterations ), baseSolution );
 
-		// Provo a mutare la soluzione in chiusura solo se possibile, ovvero se essa ha almeno due lati
-		// oppure casualmente seguendo una funzione sigmoidale basata su una media di costo e domanda.
-		if( solution->size( vehicle ) <= 2 || (float) rand() / RAND_MAX > p_close )
-			ninjaTurtle = &solver::Solver::mutateSolutionOpen;
-		else
-			ninjaTurtle = &solver::Solver::mutateSolutionClose;
+		for ( int i = 0; i < M; i++ )
+			if ( !isFeasible( &baseSolution, i ) )
+				throw 2;
+	}
 
-		// Effettuo un ciclo finchè non viene realmente effettuata una mutazione nella soluzione
-		uint current_edge = edge;
-		bool mutate = false;
-		int exterminate = 2;
-		do{
-			// Effettuo una mutazione solo se non rischio di causare infeasibilità ad altri veicoli
-			if( isRemovable( solution, vehicle, current_edge ) )
-				mutate = (*this.*ninjaTurtle)( solution, vehicle, current_edge );
+	return baseSolution;
+}
 
-			// Passo al successivo lato nel caso in cui non ci sia stata una mutazione
-			current_edge = ( current_edge + 1 ) % solution->size( vehicle );
+Solution Solver::vns( int nIter, Solution baseSolution )
+{
+	// Inizializzo il generatore di numeri casuali
+	srand( (uint)time( NULL ) );
+	int k = 1;
+	// Creo una copia della soluzione iniziale sulla quale applicare la vns
+	Solution shakedSolution = baseSolution;
+	Solution* optimalSolution = new Solution( baseSolution );
+	// Criterio con cui spostarsi anche su soluzioni non miglioranti ( ACCEPT )
+	Acceptance acceptance( parameters.accept, parameters, baseSolution.getProfit(), bound.getUpperBound(), nIter );
+	// Bit "don't look" di ogni veicolo: posizioni in cui aprire un buco non ha dato miglioramenti,
+	//  allineate ai lati del percorso su cui sono state cercate e valide solo finché la soluzione
+	//  serve gli stessi lati ( un lato lasciato da un altro veicolo può rendere utile una chiusura )
+	vector< vector<Edge*> > lookedRoutes( M );
+	vector< boost::dynamic_bitset<> > lookedServed( M );
+	vector< vector<bool> > dontLook( M );
+
+	// Se richiesto, stampo i risultati su un file esterno
+	if( output_file.is_open() )
+	{
+		printToFile( &shakedSolution );
+		printToFile( &baseSolution );
+	}
+	
+	// Ciclo fino a quando la stopping rule me lo consente o prima se trovo una soluzione migliore di quella iniziale
+	while ( nIter-- > 0 )
+	{
+		// Inutile proseguire se la soluzione ottima non può più migliorare abbastanza
+		if ( isGapClosed( optimalSolution ) )
+			break;
+
+		// Copio la soluzione di base su una soluzione che elaborerò nella vns
+		shakedSolution = Solution( baseSolution );
 
-			// Se ho finito un giro senza aver effettuato mutazioni nella soluzione, allora cambio funzione e ricomincio da capo.
-			// Se anche l'altra funzione non ha alcun effetto, allora termino la funzione.
-			if( current_edge == edge )
-			{
-				if( ninjaTurtle == &solver::Solver::mutateSolutionOpen )
-				{
-					if( solution->size( vehicle ) > 2 )
-					{
-						ninjaTurtle = &solver::Solver::mutateSolutionClose;
 #ifdef DEBUG
-						cerr << "Cambio a close" << endl;
+		cerr << "shakedSolution = Solution( baseSolution ): " << endl << "Base: " << baseSolution.toString() << "Shaked: " << shakedSolution.toString() << endl;
 #endif
-					}
-					else
-					{
-						exterminate = 0;
+
+		
+		/*** Shaking ***/
+		// Estraggo un veicolo ed un lato iniziale casuali
+		// Tengo traccia anche dei nodi sorgente e destinazione di tale lato
+		uint vehicle = rand() % M;
+
 #ifdef DEBUG
-						cerr << "Non cambio a close" << endl;
+		cerr << "VNS " << nIter << " sul veicolo " << vehicle << endl;
 #endif
-					}
 
+		// MrBean colpisce ancora
+		// Utile per essere sicuri di fare tutte le ottimizzazioni possibili
+		mrBeanBeanBinPacking( &shakedSolution, vehicle );
+
+#ifdef DEBUG
+		cerr << "infra shake " << shakedSolution.toString();
+#endif
+
+		// Non mi interesso del valore di ritorno perché pressoché inutile. :D
+		mutateSolution( &shakedSolution, vehicle, ceil( parameters.xi * ( k + 1 ) ) );
+
+		// Una soluzione già cercata darebbe le stesse ricerche locali
+		bool searched = markVisited( shakedSolution );
+
+#ifdef DEBUG
+		cerr << "Soluzioni:" << endl;
+		cerr << "Base: " << baseSolution.toString();
+		cerr << "Shaked: " << shakedSolution.toString();
+		cerr << "Optimal: " << optimalSolution->toString();
+#endif
+		
+		/*** Ricerca locale ***/
+		// Adottiamo il criterio di best improvement e non first.
+		// Per prima cosa dobbiamo copiare la soluzione corrente in una temporanea che indicherà la soluzione con massimo profitto trovato.
+		// Se si accettano anche peggioramenti, il candidato è il migliore tra la soluzione shakerata e le sue ricerche locali.
+		Solution maxSolution = Solution( parameters.accept == ACCEPT_STRICT ? baseSolution : shakedSolution );
+		Solution localSearchSolution( shakedSolution );
+		// Con FIRST_IMPROVEMENT mi fermo al primo buco la cui chiusura migliora
+		bool improved = false;
+
+		for ( int v = 0; v < M && !searched && !improved; v++ )
+		{
+			// Cerco di ottimizzare il veicolo appena shakerato
+			localSearchSolution = Solution( shakedSolution );
+			mrBeanBeanBinPacking( &localSearchSolution, v );
+			cleanVehicle( &localSearchSolution, v );
+
+			// Di un percorso cambiato riguardo solo il tratto diverso ed i suoi vicini:
+			//  i bit del prefisso e del suffisso comuni col percorso già cercato restano validi
+			vector<Edge*> route( localSearchSolution.size( v ) );
+			for ( int i = 0; i < route.size(); i++ )
+				route[ i ] = localSearchSolution.getEdge( v, i )->getEdge();
+
+			const vector<Edge*>& looked = lookedRoutes[ v ];
+			uint prefix = 0,
+				 suffix = 0;
+			while ( prefix < route.size() && prefix < looked.size() && route[ prefix ] == looked[ prefix ] )
+				prefix++;
+			while ( prefix + suffix < route.size() && prefix + suffix < looked.size() &&
+					route[ route.size() - 1 - suffix ] == looked[ looked.size() - 1 - suffix ] )
+				suffix++;
+
+			vector<bool>& bits = dontLook[ v ];
+			boost::dynamic_bitset<> served = localSearchSolution.getServed();
+			if ( served != lookedServed[ v ] )
+			{
+				bits.assign( route.size(), false );
+				lookedServed[ v ] = served;
+			}
+			else
+			{
+				bits.erase( bits.begin() + prefix, bits.end() - suffix );
+				bits.insert( bits.begin() + prefix, route.size() - prefix - suffix, false );
+				if ( prefix + suffix < max( route.size(), looked.size() ) )
+				{
+					if ( prefix > 0 )
+						bits[ prefix - 1 ] = false;
+					if ( suffix > 0 )
+						bits[ route.size() - suffix ] = false;
+				}
+			}
+			lookedRoutes[ v ] = route;
+
+#ifdef DEBUG
+			cerr << "Ricerco localmente su " << v << ": " << localSearchSolution.toString( v );
+#endif
+
+			uint previous = depot;
+			uint next;
+			for ( int i = 0; i < localSearchSolution.size( v ); i++ )
+			{
+#ifdef DEBUG
+				cerr << "Lavoro sul veicolo " << v << " lato " << i;
+				cerr << " ( " << localSearchSolution.getEdge( v, i )->getSrc() << " " << localSearchSolution.getEdge( v, i )->getDst() << " ) " << endl;
+				cerr << "Parto da: " << localSearchSolution.toString();
+#endif
+				if ( parameters.dontLook && dontLook[ v ][ i ] )
+				{
+					previous = localSearchSolution.getEdge( v, i )->getDst( previous );
+					continue;
+				}
+				dontLook[ v ][ i ] = true;
+
+				// Elimino almeno un lato
+				list <Edge*> removedEdges;
+				bool wasServer;
+
+				Vehicle* tempVehicle = localSearchSolution.getVehicle( v );
+				
+				MetaEdge* tempMeta = localSearchSolution.getEdge( v, i );
+				wasServer = tempMeta->isServer( tempVehicle );
+				// Pro thinking:
+				// Se MrBean non è riuscito a riassegnare questo lato ad altri veicoli ed io non sono l'unico che lo attraversa,
+				// è inutile cercare di toglierlo dalla soluzione in quanto renderebbe infeasible un altro veicolo, per cui salto.
+				if( !isRemovable( &localSearchSolution, v, i ) )
+				{
+#ifdef DEBUG
+					cerr << "Il lato " << i << " non è rimovibile. Passo al lato successivo." << endl;
+#endif
+					previous = tempMeta->getDst( previous );
+					continue;
+				}
+
+				removedEdges.push_back( tempMeta->getEdge() );
+
+				localSearchSolution.removeEdge( v, i );
+				next = tempMeta->getDst( previous );
+
+				// Elimino lati dalla soluzione fintanto che questi non ne aumentano il profitto e fintanto che sono presenti nella soluzione
+				while( i < localSearchSolution.size( v ) && isRemovable( &localSearchSolution, v, i ) )
+				{
+					// Calcolo la differenza di profitto che abbiamo nel togliere un lato alla soluzione
+					int diffProfit = localSearchSolution.getProfit( v );
+
+					// Rimuovo il lato i
+					MetaEdge* temp = localSearchSolution.getEdge( v, i );
+					localSearchSolution.removeEdge( v, i );
+
+					diffProfit -= localSearchSolution.getProfit( v );
+
+					// Se non ho differenze di profitto, tolgo quel lato dalla soluzione
+					if( diffProfit == 0 )
+					{
+						// Sposto il nodo di partenza
+						next = temp->getDst( next );
+						// Inserisco il lato tolto nella lista
+						removedEdges.push_back( temp->getEdge() );
+					}
+					else
+					{
+						// Altrimenti lo riaggiungo
+						localSearchSolution.addEdge( temp->getEdge(), v, i );
+						//temp->setServer( tempVehicle );
+						break;
+					}
+
+				}
+
+#ifdef DEBUG
+				cerr << "Creato un buco di " << removedEdges.size() << " lati su ( " << previous << " " << next << " ) " << endl;
+				cerr << "Cristo: " << localSearchSolution.toString() << endl;
+#endif
+
+				// Con FIRST_IMPROVEMENT mi basta la prima chiusura corta che migliora;
+				//  altrimenti, o se non ne trovo, chiedo a Dijkstra di calcolarmi la chiusura migliore
+				list<Edge*> closure;
+				if ( parameters.firstImprovement )
+					closure = closeSolutionFirst( &localSearchSolution, v, previous, next,
+												  min( (int)removedEdges.size() + 1, FIRST_CLOSURE_EDGES ), i, maxSolution );
+				if ( !closure.size() )
+					closure = closeSolutionDijkstra( localSearchSolution, v, previous, next, i );
+				previous = next;
+
+				if ( !closure.size() )
+				{
+					// Quell'incapace del Sig. Bellman-Ford-Zucchelli ha fallito: ripristino.
+					for( auto it = removedEdges.rbegin(); it != removedEdges.rend(); ++it )
+						localSearchSolution.addEdge( *it, v, i );
+	
+					if( wasServer )
+					{
+#ifdef DEBUG
+						cerr << "PIPPIRIPACCHIO1 questa variabile è utile" << endl;
+#endif
+						localSearchSolution.getEdge( v, i )->setServer( tempVehicle );
+					}
+
+					i += removedEdges.size() - 1;
+					continue;
+				}
+
+				// Se questo porta un miglioramento, effettuo la chiusura, altrimenti riaggiungo il lato i
+				for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
+					localSearchSolution.addEdge( *it, v, i );
+
+#ifdef DEBUG
+				cerr << "Soluzioni dopo ricerca locale: " << localSearchSolution.toString() << endl;
+#endif
+
+				// Il percorso appena chiuso è un candidato per il pool
+				if ( parameters.routePool > 0 && isFeasible( &localSearchSolution, v ) )
+					pool.offer( Route( localSearchSolution, v, graph, depot ) );
+
+				// Controllo se ho trovato una soluzione migliore della massima trovata in precedenza
+				if ( localSearchSolution > maxSolution )
+				{
+#ifdef DEBUG
+					cerr << "Migliorato" << endl;
+#endif
+					maxSolution = Solution( localSearchSolution );
+					dontLook[ v ][ i ] = false;
+
+					if ( parameters.firstImprovement )
+					{
+						improved = true;
+						break;
+					}
+				}
+
+				// Resetto la shakedSolution per effettuare una nuova ricerca
+				for( int j = 0; j < closure.size(); j++ )
+					localSearchSolution.removeEdge( v, i );
+
+				for( auto it = removedEdges.rbegin(); it != removedEdges.rend(); ++it )
+					localSearchSolution.addEdge( *it, v, i );
+
+//				if( wasServer )
+//				{
+//#ifdef DEBUG
+//					cerr << "PIPPIRIPACCHIO2 questa variabile è utile" << endl;
+//#endif
+//					localSearchSolution.getEdge( v, i )->setServer( tempVehicle );
+//				}
+
+#ifdef DEBUG
+				cerr << "Fine ciclo: ripristinata la shakedSolution iniziale?" << endl;
+				cerr << "Shaked: " << localSearchSolution.toString() << endl;
+#endif
+
+				i += removedEdges.size() - 1;
+			}
+		}
+		
+		
+		/*** Move or not ***/
+		// Prima di confrontarla, percorro i servizi nei versi migliori
+		orientServices( &maxSolution );
+		pool.offer( maxSolution );
+
+		// Soluzione migliore: maggior profitto o stesso profitto con minori risorse
+		// Aggiorno la soluzione con quella più profittevole => mi sposto
+		// ( o con una non migliorante, se il criterio di accettazione lo consente )
+		if ( acceptance.accept( maxSolution, baseSolution, *optimalSolution ) )
+		{
+#ifdef DEBUG
+			cerr << "Soluzione migliorata: " << baseSolution.getProfit() << " => " << maxSolution.getProfit() << endl;
+#endif
+			// La prendo come soluzione ottima se il miglioramento è assoluto
+			if ( maxSolution > *optimalSolution )
+			{
+#ifdef DEBUG
+				cerr << "Nuovo massimo: " << optimalSolution->getProfit() << " => " << maxSolution.getProfit() << endl;
+#endif
+				// Cancello l'oggetto per liberare memoria e poi lo ricreo
+				delete optimalSolution;
+				optimalSolution = new Solution( maxSolution );
+				reportGap( optimalSolution );
+			}
+			
+			// Salvo la nuova soluzione come soluzione di base per i cicli successivi
+			baseSolution = maxSolution;
+			elite.offer( baseSolution );
+			
+			k = 0;
+		}
+
+		// Di tanto in tanto ricombino i percorsi raccolti, ripartendo dalla ricombinazione se migliora
+		if ( parameters.poolPeriod > 0 && pool.size() && nIter % parameters.poolPeriod == 0 )
+		{
+			Solution packed = recombineRoutes( *optimalSolution );
+			if ( packed > *optimalSolution )
+			{
+				delete optimalSolution;
+				optimalSolution = new Solution( packed );
+				reportGap( optimalSolution );
+				baseSolution = packed;
+				k = 0;
+			}
+		}
+
+		acceptance.update( baseSolution );
+
+		// Come all'inizio, se richiesto stampo su file i risultati
+		if( output_file.is_open() )
+		{
+			printToFile( &shakedSolution );
+			printToFile( &baseSolution );
+		}
+
+		for ( int i = 0; i < M; i++ )
+			if ( !isFeasible( &shakedSolution, i ) )
+				throw 2;
+
+		// Incremento il numero di iterazioni svolte
+		k = 1 + k % parameters.kMax;
+	}
+	
+	reportVisited();
+
+	// Ottimizzazione finale
+	optimizeSolution( optimalSolution );
+	
+#ifdef DEBUG
+	cerr << "VNS" << optimalSolution->toString();
+#endif
+	return *optimalSolution;
+}
+
+Solution Solver::vnd( int nIter, Solution baseSolution )
+{
+	// Inizializzo il generatore di numeri casuali
+	srand( (uint)time( NULL ) );
+	int k = 1;
+	// Creo una copia della soluzione iniziale sulla quale applicare la vns
+	Solution shakedSolution = baseSolution;
+	Solution* optimalSolution = new Solution( baseSolution );
+	// Criterio con cui spostarsi anche su soluzioni non miglioranti ( ACCEPT )
+	Acceptance acceptance( parameters.accept, parameters, baseSolution.getProfit(), bound.getUpperBound(), nIter );
+	
+	// Se richiesto, stampo i risultati su un file esterno
+	if( output_file.is_open() )
+	{
+		printToFile( &shakedSolution );
+		printToFile( &baseSolution );
+	}
+
+	// Ciclo fino a quando la stopping rule me lo consente o prima se trovo una soluzione migliore di quella iniziale
+	while ( nIter-- > 0 )
+	{
+		// Inutile proseguire se la soluzione ottima non può più migliorare abbastanza
+		if ( isGapClosed( optimalSolution ) )
+			break;
+
+		shakedSolution = Solution( baseSolution );
+		
+		/*** Shaking ***/
+		// Estraggo un veicolo ed un lato iniziale casuali
+		// Tengo traccia anche dei nodi sorgente e destinazione di tale lato
+		uint vehicle = rand() % M,
+			 src,
+			 dst;
+		int	 edge = -1;
+
+#ifdef DEBUG
+		cerr << "VND " << nIter << " su " << vehicle << endl;
+#endif
+
+		// Prima di generare un buco nella soluzione, la muto, così da partire da
+		// una soluzione diversa ad ogni ciclo, e non sempre dalla stessa.
+		mutateSolution( &shakedSolution, vehicle, ceil( k ) );
+
+		// Verifico che il buco sia stato creato correttamente
+		try
+		{
+			edge = openSolutionRandom( &shakedSolution, vehicle, k, &src, &dst );
+			if ( edge < 0 || edge >= shakedSolution.size() )
+				throw 10;
+		}
+		catch( int e )
+		{
+#ifdef DEBUG
+			cerr << "Open fallita " << e << endl;
+#endif
+			continue;
+		}
+		
+#ifdef DEBUG
+		cerr << shakedSolution.toString();
+		cerr << "Buco " << src << " " << dst << "\tindice " << edge << endl;
+#endif
+		
+		// Cerco di ottimizzare il veicolo appena shakerato
+		mrBeanBeanBinPacking( &shakedSolution, vehicle );
+
+		// Il buco è già stato chiuso da una soluzione identica: la chiusura sarebbe la stessa,
+		//  per cui passo all'intorno successivo
+		if ( markVisited( shakedSolution ) )
+		{
+			k = 1 + k % parameters.kMax;
+			continue;
+		}
+
+		list<Edge*> closure = closeSolutionDijkstra( shakedSolution, vehicle, src, dst, edge );
+		if ( !closure.size() )
+		{
+#ifdef DEBUG
+			cerr << "Pippero." << endl;
+#endif
+			continue;
+		}
+
+		for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
+			shakedSolution.addEdge( *it, vehicle, edge );
+
+/*
+		// Ottimizzo la soluzione
+		optimizeSolution( &shakedSolution );
+*/
+		
+#ifdef DEBUG
+		cerr << "Soluzioni:" << endl;
+		cerr << "Base: " << baseSolution.toString();
+		cerr << "Shaked: " << shakedSolution.toString();
+		cerr << "Optimal: " << optimalSolution->toString();
+#endif
+		
+		/*** Move or not ***/
+		// Prima di confrontarla, percorro i servizi nei versi migliori
+		orientServices( &shakedSolution );
+		pool.offer( shakedSolution );
+
+		// Soluzione migliore: maggior profitto o stesso profitto con minori risorse
+		// Aggiorno la soluzione con quella più profittevole => mi sposto
+		// ( o con una non migliorante, se il criterio di accettazione lo consente )
+		if ( acceptance.accept( shakedSolution, baseSolution, *optimalSolution ) )
+		{
+#ifdef DEBUG
+			cerr << "Soluzione migliorata: " << baseSolution.getProfit() << " => " << shakedSolution.getProfit() << endl;
+#endif
+			if ( shakedSolution > *optimalSolution )
+			{
+#ifdef DEBUG
+				cerr << "Nuovo massimo: " << optimalSolution->getProfit() << " => " << shakedSolution.getProfit() << endl;
+#endif
+				optimalSolution = new Solution( shakedSolution );
+				reportGap( optimalSolution );
+			}
+			
+			baseSolution = shakedSolution;
+			elite.offer( baseSolution );
+			
+			k = 0;
+		}
+
+		// Di tanto in tanto ricombino i percorsi raccolti, ripartendo dalla ricombinazione se migliora
+		if ( parameters.poolPeriod > 0 && pool.size() && nIter % parameters.poolPeriod == 0 )
+		{
+			Solution packed = recombineRoutes( *optimalSolution );
+			if ( packed > *optimalSolution )
+			{
+				delete optimalSolution;
+				optimalSolution = new Solution( packed );
+				reportGap( optimalSolution );
+				baseSolution = packed;
+				k = 0;
+			}
+		}
+
+		acceptance.update( baseSolution );
+
+		// Come all'inizio, se richiesto stampo su file i risultati
+		if( output_file.is_open() )
+		{
+			printToFile( &shakedSolution );
+			printToFile( &baseSolution );
+		}
+
+		for ( int i = 0; i < M; i++ )
+			if ( !isFeasible( &shakedSolution, i ) )
+			{
+#ifdef DEBUG
+				cerr << "Esco per unfeasability di " << i << endl;
+#endif
+				throw 2;
+			}
+
+		k = 1 + k % parameters.kMax;
+	}
+	
+	reportVisited();
+
+	// Ottimizzazione finale
+	optimizeSolution( optimalSolution );
+	
+#ifdef DEBUG
+	cerr << "VND" << optimalSolution->toString();
+#endif
+	return *optimalSolution;
+}
+
+uint Solver::mutateSolution( Solution *solution, uint vehicle, int k )
+{
+	// Inizializzo la funzione random
+	srand( (uint)time( NULL ) );
+
+	// Se il veicolo e` vuoto, lo genero e poi lo muto
+	// ( teoricamente meglio greedy, ma... )
+	if ( !solution->size( vehicle ) )
+	{
+		list<Edge*> closure = closeSolutionDijkstra( *solution, vehicle, depot, depot, 0 );
+		
+		if ( !closure.size() )
+		{
+			// Non esiste modo di chiudere il veicolo. È inutile fare altro.
+			return 0;
+		}
+		
+		for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
+			solution->addEdge( *it, vehicle, 0 );
+	}
+
+	// Barbatrucco: puntatore a funzioni per essere più efficienti nella scrittura del codice.
+	// Definisco un puntatore alle funzioni usate per aprire o chiudere la soluzione corrente.
+	// Questo verrà istanziato a seconda della casualità ad una delle due funzioni.
+	bool (solver::Solver::* ninjaTurtle)( Solution*, uint, int );
+
+	// Devo modificare la soluzione passatami per k volte
+	// Ciclo sul numero di volte calcolato
+	for( int i = 0; i < k; i++ )
+	{
+		// Scelgo un lato sul quale operare
+		int edge = rand() % solution->size( vehicle );
+
+		// Casualmente scelgo se aprire o chiudere un lato
+		// Non mi interesso del valore di ritorno delle funzioni usate perchè so già dove il buco è stato creato, essendo io a passarlo come parametro.
+		float x = ( (float)( solution->getDemand( vehicle ) / Q + solution->getCost( vehicle ) / tMax ) / 2 );
+		// Funzione di pesatura scelta tra i parametri ( di default x / sqrt( 1 + x^2 ) )
+		float p_close = parameters.getCloseProbability( x );
+
+
+		// Provo a mutare la soluzione in chiusura solo se possibile, ovvero se essa ha almeno due lati
+		// oppure casualmente seguendo una funzione sigmoidale basata su una media di costo e domanda.
+		if( solution->size( vehicle ) <= 2 || (float) rand() / RAND_MAX > p_close )
+			ninjaTurtle = &solver::Solver::mutateSolutionOpen;
+		else
+			ninjaTurtle = &solver::Solver::mutateSolutionClose;
+
+		// Effettuo un ciclo finchè non viene realmente effettuata una mutazione nella soluzione
+		uint current_edge = edge;
+		bool mutate = false;
+		int exterminate = 2;
+		do{
+			// Effettuo una mutazione solo se non rischio di causare infeasibilità ad altri veicoli
+			if( isRemovable( solution, vehicle, current_edge ) )
+				mutate = (*this.*ninjaTurtle)( solution, vehicle, current_edge );
+
+			// Passo al successivo lato nel caso in cui non ci sia stata una mutazione
+			current_edge = ( current_edge + 1 ) % solution->size( vehicle );
+
+			// Se ho finito un giro senza aver effettuato mutazioni nella soluzione, allora cambio funzione e ricomincio da capo.
+			// Se anche l'altra funzione non ha alcun effetto, allora termino la funzione.
+			if( current_edge == edge )
+			{
+				if( ninjaTurtle == &solver::Solver::mutateSolutionOpen )
+				{
+					if( solution->size( vehicle ) > 2 )
+					{
+						ninjaTurtle = &solver::Solver::mutateSolutionClose;
+#ifdef DEBUG
+						cerr << "Cambio a close" << endl;
+#endif
+					}
+					else
+					{
+						exterminate = 0;
+#ifdef DEBUG
+						cerr << "Non cambio a close" << endl;
+#endif
+					}
+
+				}
+				else
+				{
+					ninjaTurtle = &solver::Solver::mutateSolutionOpen;
+#ifdef DEBUG
+					cerr << "Cambio a open" << endl;
+#endif
+				}
+
+				exterminate--;
+			}
+
+		}while( exterminate > 0 && !mutate );
+
+		// Teoricamente servirebbe qualcosa di questo tipo
+		// Saremmo in una soluzione inamovibile, per cui sarebbe insensato cercare di continuare a modificarla.
+		if( exterminate <= 0 )
+		{
+#ifdef DEBUG
+			cerr << "Non ho fatto una mazza" << endl;
+#endif
+			return false;
+		}
+		
+
+	}
+
+	return (uint)solution->size();
+}
+
+bool Solver::mutateSolutionClose( Solution *solution, uint vehicle, int edge )
+{
+	// Estraggo un lato casuale dalla soluzione se non differentemente indicato
+	if( edge == -1 )
+		edge = (uint) rand() % ( solution->size( vehicle ) - 1 );
+	else
+		if( edge == solution->size( vehicle ) - 1 )
+			return false;
+
+	// Se uno dei due lati della chiusura non è rimovibile, non posso agire
+	if ( !isRemovable( solution, vehicle, edge ) || !isRemovable( solution, vehicle, edge + 1 ) )
+		return false;
+
+	uint src = solution->getEdge( vehicle, edge )->getSrc();
+	uint dst = solution->getEdge( vehicle, edge )->getDst();
+
+	if( !solution->getDirection( vehicle, edge ) )
+		dst ^= src ^= dst ^= src;
+
+#ifdef DEBUG
+	cerr << "Close " << edge << ": ( " << src << ", " << dst << " ) " << endl;
+#endif
+
+	// Ricavo la destinazione della destinazione dal lato scelto
+	uint final_dst = solution->getEdge( vehicle, edge + 1 )->getDst( dst );
+	Edge* first = graph.getEdge( src, dst );
+	Edge* second = graph.getEdge( dst, final_dst );
+
+	// Elimino i lati src->dst e dst->final_dst
+	solution->removeEdge( vehicle, edge );
+	solution->removeEdge( vehicle, edge );
+
+	// Inserisco il lato che unisce src->final_dst
+	bool autoCiclo = src == final_dst;
+	if( !autoCiclo )
+		solution->addEdge( graph.getEdge( src, final_dst ), vehicle, edge );
+
+	// Devo controllare la feasibility per eventuali problemi di domanda
+	if( isFeasible( solution, vehicle ) )
+	{
+#ifdef DEBUG
+		cerr << "Close completato sul lato ( " << src << ", " << dst << " ) ";
+		cerr << "chiuso con ( " << src << " " << final_dst << " ) escludendo il nodo " << dst << endl;
+#endif
+		return true;
+	}
+	else
+	{
+		if ( !autoCiclo )
+			solution->removeEdge( vehicle, edge );
+
+		solution->addEdge( second, vehicle, edge );
+		solution->addEdge( first, vehicle, edge );
+
+	}
+
+	return false;
+}
+
+bool Solver::mutateSolutionOpen( Solution *solution, uint vehicle, int edge )
+{
+	// Estraggo un lato casuale dalla soluzione se non già indicato
+	if( edge == -1 )
+		edge = (uint) rand() % solution->size( vehicle );
+
+	// Se il lato non è rimovibile, non posso agire
+	if ( !isRemovable( solution, vehicle, edge ) )
+		return false;
+
+	uint src = solution->getEdge( vehicle, edge )->getSrc();
+	uint dst = solution->getEdge( vehicle, edge )->getDst();
+
+	if( !solution->getDirection( vehicle, edge ) )
+		dst ^= src ^= dst ^= src;
+
+#ifdef DEBUG
+	cerr << "Open " << edge << ": ( " << src << ", " << dst << " ) " << endl;
+#endif
+
+	// Tengo solo i nodi, tra i più vicini, per cui la deviazione sta nel tempo residuo del veicolo,
+	//  a cui si aggiunge quello del lato tolto
+	Edge* removed = solution->getEdge( vehicle, edge )->getEdge();
+	int slack = (int)tMax - (int)solution->getCost( vehicle ) + (int)removed->getCost() - (int)graph.getDistance( src, dst );
+	vector<uint> closers = graph.getDetours( src, dst, max( 0, slack ), parameters.neighbours );
+
+	while ( !closers.empty() )
+	{
+		// Estraggo un nodo non ancora testato
+		int chosen = rand() % closers.size();
+		uint closer = closers[ chosen ];
+		closers[ chosen ] = closers.back();
+		closers.pop_back();
+
+/*
+#ifdef DEBUG
+		cerr << "Test: " << closers.size();
+		cerr << ". Ho scelto te: " << closer;
+		cerr << " per aprire ( " << src << ", " << dst << " ) " << endl;
+#endif
+*/
+		// Rimuovo il lato dalla soluzione
+		solution->removeEdge( vehicle, edge );
+		
+
+		// Chiudo la soluzione e verifico se la soluzione è feasible
+		// Inserimento al "contrario" perché l'inserimento viene effettuato prima dell'indice del lato scelto.
+		solution->addEdge( graph.getEdge( closer, dst ), vehicle, edge );
+		solution->addEdge( graph.getEdge( src, closer ), vehicle, edge );
+
+		// Controllo la feasibilità della nuova soluzione
+		if( isFeasible( solution, vehicle ) )
+		{
+#ifdef DEBUG
+			cerr << "Open completato con nodo " << closer << endl;
+#endif
+			return true;
+		}
+		else
+		{
+			// Ripristino la soluzione iniziale
+			solution->removeEdge( vehicle, edge );
+			solution->removeEdge( vehicle, edge );
+			solution->addEdge( removed, vehicle, edge );
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Cede il servizio di un lato casuale servito dal veicolo ad un altro veicolo che lo attraversa,
+ * se questo resta ammissibile.
+ *
+ * @param solution	la soluzione da modificare
+ * @param vehicle	il veicolo che cede il servizio
+ * @return	vero, se lo scambio è stato effettuato
+ */
+bool Solver::swapServer( Solution* solution, uint vehicle )
+{
+	Vehicle* giver = solution->getVehicle( vehicle );
+
+	vector<MetaEdge*> shared;
+	for ( int i = 0; i < solution->size( vehicle ); i++ )
+	{
+		MetaEdge* edge = solution->getEdge( vehicle, i );
+		if ( edge->getProfit() > 0 && edge->isServer( giver ) && edge->getTaken() > 1 )
+			shared.push_back( edge );
+	}
+
+	if ( shared.empty() )
+		return false;
+
+	MetaEdge* edge = shared[ rand() % shared.size() ];
+
+	vector<const Vehicle*> takers;
+	for ( const Vehicle* taker : edge->getTakers() )
+		if ( *taker != *giver )
+			takers.push_back( taker );
+
+	const Vehicle* receiver = takers[ rand() % takers.size() ];
+	edge->setServer( receiver );
+
+	if ( isFeasible( solution, solution->getVehicleIndex( receiver ) ) )
+		return true;
+
+	edge->setServer( giver );
+	return false;
+}
+
+/**
+ * Applica al veicolo una mossa casuale della tabu search.
+ * Un veicolo vuoto viene prima generato con una chiusura sul deposito.
+ *
+ * @param solution	la soluzione da modificare
+ * @param vehicle	il veicolo su cui agire
+ * @return	vero, se la soluzione è stata modificata
+ */
+bool Solver::tabuMove( Solution* solution, uint vehicle )
+{
+	if ( !solution->size( vehicle ) )
+	{
+		list<Edge*> closure = closeSolutionDijkstra( *solution, vehicle, depot, depot, 0 );
+
+		for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
+			solution->addEdge( *it, vehicle, 0 );
+
+		return closure.size() > 0;
+	}
+
+	switch ( rand() % 3 )
+	{
+		case 0:
+			return mutateSolutionOpen( solution, vehicle );
+
+		case 1:
+			// La chiusura richiede almeno due lati oltre al ritorno
+			return solution->size( vehicle ) > 2 && mutateSolutionClose( solution, vehicle );
+
+		default:
+			return swapServer( solution, vehicle );
+	}
+}
+
+/**
+ * Applica un operatore di distruzione della ALNS.
+ *
+ * @param solution	la soluzione da distruggere
+ * @param op		l'operatore ( vedi alns )
+ * @param k			il numero di lati da rimuovere per ogni tratto
+ * @param holes		i buchi lasciati, al più uno per veicolo
+ * @return	vero, se almeno un lato è stato rimosso
+ */
+bool Solver::destroySolution( Solution* solution, int op, int k, vector<Hole>* holes )
+{
+	vector<uint> used;
+	for ( int v = 0; v < M; v++ )
+		if ( solution->size( v ) )
+			used.push_back( v );
+
+	if ( used.empty() )
+		return false;
+
+	uint vehicle = used[ rand() % used.size() ];
+
+	switch ( op )
+	{
+		// Tratto casuale
+		case 0:
+		{
+			if ( solution->size( vehicle ) < 2 )
+				return false;
+
+			Hole hole;
+			hole.vehicle = vehicle;
+			try
+			{
+				hole.index = openSolutionRandom( solution, vehicle, k, &hole.src, &hole.dst );
+			}
+			catch ( int e )
+			{
+				return false;
+			}
+
+			holes->push_back( hole );
+			break;
+		}
+
+		// Tratto col minor profitto per unità di costo, scelto in modo casualizzato tra i peggiori
+		case 1:
+		{
+			vector< pair<float, pair<uint, int> > > segments;
+			for ( uint v : used )
+			{
+				Vehicle* aVehicle = solution->getVehicle( v );
+				int length = min( k, (int)solution->size( v ) );
+
+				// Profitto portato da ogni lato: solo alla prima percorrenza del servente
+				set<MetaEdge*> seen;
+				vector<float> profits,
+							  costs;
+				for ( int i = 0; i < solution->size( v ); i++ )
+				{
+					MetaEdge* edge = solution->getEdge( v, i );
+					bool first = seen.insert( edge ).second;
+					profits.push_back( first && edge->isServer( aVehicle ) ? edge->getProfit() : 0 );
+					costs.push_back( edge->getCost() );
+				}
+
+				float profit = 0,
+					  cost = 0;
+				for ( int i = 0; i < solution->size( v ); i++ )
+				{
+					profit += profits[ i ];
+					cost += costs[ i ];
+					if ( i >= length )
+					{
+						profit -= profits[ i - length ];
+						cost -= costs[ i - length ];
+					}
+
+					if ( i >= length - 1 )
+						segments.push_back( make_pair( profit / ( cost + 1 ), make_pair( v, i - length + 1 ) ) );
+				}
+			}
+
+			sort( segments.begin(), segments.end() );
+			float y = (float)rand() / RAND_MAX;
+			auto chosen = segments[ min( (int)segments.size() - 1, (int)( y * y * y * segments.size() ) ) ];
+
+			if ( !removeSegment( solution, chosen.second.first, chosen.second.second, k, holes ) )
+				return false;
+			break;
+		}
+
+		// Tratti di tutti i veicoli vicini ad un nodo casuale della soluzione
+		case 2:
+		{
+			uint seed = getVertices( solution, vehicle )[ rand() % solution->size( vehicle ) ];
+
+			for ( uint v : used )
+			{
+				vector<uint> vertices = getVertices( solution, v );
+
+				int closest = 0;
+				for ( int i = 1; i < solution->size( v ); i++ )
+					if ( graph.getDistance( vertices[ i ], seed ) < graph.getDistance( vertices[ closest ], seed ) )
+						closest = i;
+
+				removeSegment( solution, v, max( 0, closest - k / 2 ), k, holes );
+			}
+
+			if ( holes->empty() )
+				return false;
+			break;
+		}
+
+		// Intero veicolo, dopo avergli tolto i servizi che altri possono prendere
+		default:
+		{
+			mrBeanBeanBinPacking( solution, vehicle );
+			if ( !removeSegment( solution, vehicle, 0, (int)solution->size( vehicle ), holes ) )
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Applica un operatore di riparazione della ALNS.
+ * Gli inserimenti chiudono prima i buchi col collegamento diretto, che è il più breve,
+ * e poi aggiungono i lati profittevoli rimasti senza servente.
+ *
+ * @param solution	la soluzione da riparare
+ * @param op		l'operatore ( vedi alns )
+ * @param holes		i buchi lasciati dalla distruzione
+ * @return	falso, se un buco non può essere chiuso
+ */
+bool Solver::repairSolution( Solution* solution, int op, const vector<Hole>& holes )
+{
+	for ( const Hole& hole : holes )
+		if ( !closeHole( solution, hole, op == 0 ) )
+			return false;
+
+	if ( op > 0 )
+		insertProfitable( solution, op == 2 ? parameters.regret : 0 );
+
+	return true;
+}
+
+/**
+ * Chiude un buco, con la chiusura di Bellman o col collegamento diretto.
+ *
+ * @param solution	la soluzione da riparare
+ * @param hole		il buco da chiudere
+ * @param bellman	vero per usare closeSolutionDijkstra, falso per il collegamento diretto
+ * @return	falso, se il buco non può essere chiuso
+ */
+bool Solver::closeHole( Solution* solution, const Hole& hole, bool bellman )
+{
+	if ( bellman )
+	{
+		mrBeanBeanBinPacking( solution, hole.vehicle );
+
+		list<Edge*> closure = closeSolutionDijkstra( *solution, hole.vehicle, hole.src, hole.dst, hole.index );
+		for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
+			solution->addEdge( *it, hole.vehicle, hole.index );
+
+		if ( closure.size() )
+			return true;
+	}
+
+	if ( hole.src == hole.dst )
+		return true;
+
+	solution->addEdge( graph.getEdge( hole.src, hole.dst ), hole.vehicle, hole.index );
+
+	// Il collegamento diretto può servire un lato troppo oneroso: ripiego sulla chiusura
+	if ( !isFeasible( solution, hole.vehicle ) )
+	{
+		solution->removeEdge( hole.vehicle, hole.index );
+
+		list<Edge*> closure = closeSolutionDijkstra( *solution, hole.vehicle, hole.src, hole.dst, hole.index );
+		if ( !closure.size() )
+			return false;
+
+		for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
+			solution->addEdge( *it, hole.vehicle, hole.index );
+	}
+
+	return true;
+}
+
+/**
+ * Rimuove fino a length lati consecutivi a partire da start, fermandosi al primo non rimovibile.
+ *
+ * @param solution	la soluzione da modificare
+ * @param vehicle	il veicolo
+ * @param start		l'indice del primo lato da rimuovere
+ * @param length	il numero massimo di lati da rimuovere
+ * @param holes		dove aggiungere il buco creato
+ * @return	il numero di lati rimossi
+ */
+int Solver::removeSegment( Solution* solution, uint vehicle, int start, int length, vector<Hole>* holes )
+{
+	Hole hole;
+	hole.vehicle = vehicle;
+	hole.index = start;
+	hole.src = hole.dst = getVertices( solution, vehicle )[ start ];
+
+	int removed = 0;
+	while ( removed < length && start < solution->size( vehicle ) && isRemovable( solution, vehicle, start ) )
+	{
+		hole.dst = solution->getEdge( vehicle, start )->getDst( hole.dst );
+		solution->removeEdge( vehicle, start );
+		removed++;
+	}
+
+	if ( removed )
+		holes->push_back( hole );
+
+	return removed;
+}
+
+/**
+ * Inserisce i lati profittevoli non ancora presi da nessuno, finché ce ne sono di inseribili.
+ * Un lato può prendere il posto di un collegamento ( lato che non porta profitto ) del percorso,
+ * raggiungendolo e lasciandolo coi lati diretti; un veicolo vuoto lo raggiunge dal deposito.
+ * La scelta greedy massimizza il profitto per unità di tempo aggiunto; quella col rimpianto-k
+ * inserisce prima il lato che perderebbe di più se non venisse messo nel veicolo migliore,
+ * sommando la differenza dal migliore dei k - 1 veicoli successivi: passano avanti i lati con poche alternative.
+ *
+ * @param solution	la soluzione da completare
+ * @param regret	k del rimpianto, 0 per la scelta greedy
+ */
+void Solver::insertProfitable( Solution* solution, int regret )
+{
+	insertProfitable( solution, regret, bound.getEdges() );
+}
+
+/**
+ * Come sopra, limitandosi ai lati indicati.
+ *
+ * @param solution	la soluzione da completare
+ * @param regret	k del rimpianto, 0 per la scelta greedy
+ * @param edges		i lati candidati all'inserimento
+ */
+void Solver::insertProfitable( Solution* solution, int regret, const vector<Edge*>& edges )
+{
+	// Lati il cui inserimento si è rivelato non ammissibile
+	set<const Edge*> rejected;
+
+	Insertions slots( graph );
+	vector<Insertions::Best> bests;
+	vector<float> scores( M );
+	int k = min( max( regret, 1 ), (int)M );
+
+	while ( true )
+	{
+		slots.clear();
+		for ( int v = 0; v < M; v++ )
+		{
+			slots.addVehicle( (int)tMax - (int)solution->getCost( v ), (int)Q - (int)solution->getDemand( v ) );
+
+			if ( !solution->size( v ) )
+			{
+				slots.addSlot( 0, depot, depot, 0 );
+				continue;
+			}
+
+			Vehicle* aVehicle = solution->getVehicle( v );
+			vector<uint> vertices = getVertices( solution, v );
+			set<MetaEdge*> seen;
+			for ( int i = 0; i < solution->size( v ); i++ )
+			{
+				MetaEdge* edge = solution->getEdge( v, i );
+				bool first = seen.insert( edge ).second;
+				if ( ( !first || edge->getProfit() <= 0 || !edge->isServer( aVehicle ) ) &&
+					 isRemovable( solution, v, i ) )
+					slots.addSlot( i, vertices[ i ], vertices[ i + 1 ], edge->getCost() );
+			}
+		}
+
+		Edge* bestEdge = NULL;
+		uint bestVehicle = 0,
+			 bestEntry = 0;
+		int bestSlot = -1;
+		float bestValue = 0;
+
+		for ( Edge* edge : edges )
+		{
+			if ( rejected.count( edge ) || solution->getMetaEdge( edge )->getTaken() > 0 )
+				continue;
+
+			// Miglior punteggio complessivo, e punteggi migliori negli altri veicoli per il rimpianto
+			float first = 0;
+			uint firstVehicle = 0;
+
+			slots.evaluate( edge, &bests );
+			for ( int v = 0; v < M; v++ )
+			{
+				scores[ v ] = bests[ v ].score;
+				if ( bests[ v ].score > first )
+				{
+					first = bests[ v ].score;
+					firstVehicle = v;
+				}
+			}
+
+			if ( first <= 0 )
+				continue;
+
+			float value = first;
+			if ( regret && k > 1 )
+			{
+				partial_sort( scores.begin(), scores.begin() + k, scores.end(), greater<float>() );
+				value = 0;
+				for ( int j = 1; j < k; j++ )
+					value += first - scores[ j ];
+			}
+			if ( bestEdge == NULL || value > bestValue )
+			{
+				bestEdge = edge;
+				bestValue = value;
+				bestVehicle = firstVehicle;
+				bestEntry = bests[ firstVehicle ].entry;
+				bestSlot = bests[ firstVehicle ].slot;
+			}
+		}
+
+		if ( bestEdge == NULL )
+			break;
+
+		if ( !insertEdge( solution, bestVehicle, slots.getIndex( bestSlot ), slots.getSrc( bestSlot ), slots.getDst( bestSlot ),
+						  bestEdge, bestEntry ) )
+			rejected.insert( bestEdge );
+	}
+}
+
+/**
+ * Inserisce un lato al posto del collegamento index del veicolo, che va da src a dst.
+ * Se il veicolo è vuoto, il lato viene raggiunto dal deposito.
+ *
+ * @param solution	la soluzione da modificare
+ * @param vehicle	il veicolo
+ * @param index		l'indice del collegamento da sostituire
+ * @param src		il nodo di partenza del collegamento
+ * @param dst		il nodo di arrivo del collegamento
+ * @param edge		il lato da inserire
+ * @param entry		l'estremo da cui percorrere il lato
+ * @return	vero, se il veicolo resta ammissibile; altrimenti la soluzione viene ripristinata
+ */
+bool Solver::insertEdge( Solution* solution, uint vehicle, int index, uint src, uint dst, Edge* edge, uint entry )
+{
+	Edge* removed = NULL;
+	if ( solution->size( vehicle ) )
+	{
+		removed = solution->getEdge( vehicle, index )->getEdge();
+		solution->removeEdge( vehicle, index );
+	}
+
+	// Inserimento al "contrario", ogni lato va prima del precedente
+	int added = 0;
+	uint exit = edge->getDst( entry );
+	if ( exit != dst )
+	{
+		solution->addEdge( graph.getEdge( exit, dst ), vehicle, index );
+		added++;
+	}
+	solution->addEdge( edge, vehicle, index );
+	added++;
+	if ( src != entry )
+	{
+		solution->addEdge( graph.getEdge( src, entry ), vehicle, index );
+		added++;
+	}
+
+	if ( isFeasible( solution, vehicle ) )
+		return true;
+
+	for ( int i = 0; i < added; i++ )
+		solution->removeEdge( vehicle, index );
+	if ( removed != NULL )
+		solution->addEdge( removed, vehicle, index );
+
+	return false;
+}
+
+/**
+ * Ricerca locale tra coppie di veicoli sui lati serviti, in prima miglioria:
+ *  - spostamento di un servizio nella posizione migliore di un altro veicolo;
+ *  - scambio di due servizi tra veicoli;
+ *  - scambio delle code dei due percorsi ( cross exchange ).
+ * Ogni mossa ricompone i due percorsi concatenando al più tre tratti, per cui è valutata in O( 1 ),
+ * ed è migliorante se riduce il costo complessivo oppure, a costo invariato, bilancia il carico.
+ * Le mosse scelte vengono riportate sulla soluzione e verificate: i collegamenti possono servire
+ * lati ancora liberi, per cui la mossa viene tenuta solo se la soluzione resta ammissibile e migliora davvero.
+ *
+ * @param solution	la soluzione da migliorare
+ * @return	vero, se è stata applicata almeno una mossa
+ */
+bool Solver::interRouteSearch( Solution* solution )
+{
+	vector<Route> routes;
+	for ( int v = 0; v < M; v++ )
+		routes.push_back( Route( *solution, v, graph, depot ) );
+
+	// Valuta la coppia di nuovi percorsi e, se ammissibile e migliorante, prova a tenerla
+	auto attempt = [ & ]( uint a, const vector<Segment>& segmentsA, uint b, const vector<Segment>& segmentsB ) -> bool
+	{
+		const Route& A = routes[ a ];
+		const Route& B = routes[ b ];
+
+		int loadA = 0, loadB = 0;
+		for ( const Segment& segment : segmentsA )
+			loadA += segment.load;
+		for ( const Segment& segment : segmentsB )
+			loadB += segment.load;
+		if ( loadA > Q || loadB > Q )
+			return false;
+
+		int costA = A.evaluate( segmentsA ),
+			costB = B.evaluate( segmentsB );
+		if ( costA > tMax || costB > tMax )
+			return false;
+
+		// Miglioramento in costo, o a parità di costo in bilanciamento dei carichi
+		int delta = costA + costB - A.getCost() - B.getCost();
+		if ( delta > 0 || ( delta == 0 && abs( loadA - loadB ) >= abs( (int)A.getLoad() - (int)B.getLoad() ) ) )
+			return false;
+
+		return commitRoutes( solution, &routes, a, A.assemble( segmentsA ), b, B.assemble( segmentsB ) );
+	};
+
+	bool changed = false,
+		 improved = true;
+	while ( improved )
+	{
+		improved = false;
+
+		for ( int a = 0; a < M && !improved; a++ )
+			for ( int b = 0; b < M && !improved; b++ )
+			{
+				if ( a == b )
+					continue;
+
+				const Route& A = routes[ a ];
+				const Route& B = routes[ b ];
+				int nA = (int)A.size(),
+					nB = (int)B.size();
+
+				// Spostamento del servizio i di A prima del servizio j di B, in entrambi i versi
+				for ( int i = 0; i < nA && !improved; i++ )
+				{
+					if ( A.isShared( i ) )
+						continue;
+
+					Edge* s = A.getService( i );
+					vector<Segment> segmentsA = { A.getSegment( 0, i ), A.getSegment( i + 1, nA ) };
+
+					for ( int j = 0; j <= nB && !improved; j++ )
+						for ( int direction = 0; direction < 2 && !improved; direction++ )
+						{
+							uint entry = direction ? s->getDst() : s->getSrc();
+							vector<Segment> segmentsB = { B.getSegment( 0, j ), B.getSegment( s, entry ), B.getSegment( j, nB ) };
+							improved = attempt( a, segmentsA, b, segmentsB );
+						}
+				}
+
+				// Le mosse simmetriche vanno valutate una volta sola per coppia
+				if ( a > b )
+					continue;
+
+				// Scambio del servizio i di A col servizio j di B, ognuno nel verso migliore
+				for ( int i = 0; i < nA && !improved; i++ )
+				{
+					if ( A.isShared( i ) )
+						continue;
+
+					Edge* s = A.getService( i );
+					for ( int j = 0; j < nB && !improved; j++ )
+					{
+						if ( B.isShared( j ) )
+							continue;
+
+						Edge* t = B.getService( j );
+						vector<Segment> segmentsA = { A.getSegment( 0, i ), A.getSegment( t, t->getSrc() ), A.getSegment( i + 1, nA ) },
+										segmentsB = { B.getSegment( 0, j ), B.getSegment( s, s->getSrc() ), B.getSegment( j + 1, nB ) };
+
+						vector<Segment> flipped = segmentsA;
+						flipped[ 1 ] = A.getSegment( t, t->getDst() );
+						if ( A.evaluate( flipped ) < A.evaluate( segmentsA ) )
+							segmentsA = flipped;
+
+						flipped = segmentsB;
+						flipped[ 1 ] = B.getSegment( s, s->getDst() );
+						if ( B.evaluate( flipped ) < B.evaluate( segmentsB ) )
+							segmentsB = flipped;
+
+						improved = attempt( a, segmentsA, b, segmentsB );
+					}
+				}
+
+				// Scambio delle code: A tiene i primi i servizi e prosegue con quelli di B da j in poi, e viceversa
+				for ( int i = 0; i <= nA && !improved; i++ )
+					for ( int j = 0; j <= nB && !improved; j++ )
+					{
+						// Scambiare le code intere o vuote non cambia nulla
+						if ( ( i == 0 && j == 0 ) || ( i == nA && j == nB ) )
+							continue;
+
+						improved = attempt( a, { A.getSegment( 0, i ), B.getSegment( j, nB ) },
+											b, { B.getSegment( 0, j ), A.getSegment( i, nA ) } );
+					}
+			}
+
+		changed |= improved;
+	}
+
+	return changed;
+}
+
+/**
+ * Ricerca locale interna ad un veicolo, in prima miglioria sul costo:
+ *  - 2-opt: il tratto di servizi da i a j escluso viene percorso al contrario;
+ *  - Or-opt: una catena di 1-3 servizi viene spostata altrove, in uno dei due versi.
+ * Entrambe le mosse concatenano al più quattro tratti del percorso, per cui si valutano in O( 1 ).
+ *
+ * @param solution	la soluzione da migliorare
+ * @param vehicle	il veicolo
+ * @return	vero, se è stata applicata almeno una mossa
+ */
+bool Solver::intraRouteSearch( Solution* solution, uint vehicle )
+{
+	Route route( *solution, vehicle, graph, depot );
+
+	// Riporta il percorso sulla soluzione, se più corto
+	auto attempt = [ & ]( const vector<Segment>& segments ) -> bool
+	{
+		if ( route.evaluate( segments ) >= route.getCost() || !commitRoute( solution, vehicle, route.assemble( segments ) ) )
+			return false;
+
+		route = Route( *solution, vehicle, graph, depot );
+		return true;
+	};
+
+	bool changed = false,
+		 improved = true;
+	while ( improved )
+	{
+		improved = false;
+		int n = (int)route.size();
+
+		// 2-opt
+		for ( int i = 0; i < n && !improved; i++ )
+			for ( int j = i + 1; j <= n && !improved; j++ )
+				improved = attempt( { route.getSegment( 0, i ), route.getSegment( i, j, true ), route.getSegment( j, n ) } );
+
+		// Or-opt
+		for ( int length = 1; length <= 3 && !improved; length++ )
+			for ( int i = 0; i + length <= n && !improved; i++ )
+				for ( int position = 0; position <= n && !improved; position++ )
+				{
+					if ( position >= i && position <= i + length )
+						continue;
+
+					for ( int reversed = 0; reversed < 2 && !improved; reversed++ )
+					{
+						Segment chain = route.getSegment( i, i + length, reversed );
+
+						if ( position < i )
+							improved = attempt( { route.getSegment( 0, position ), chain,
+												  route.getSegment( position, i ), route.getSegment( i + length, n ) } );
+						else
+							improved = attempt( { route.getSegment( 0, i ), route.getSegment( i + length, position ),
+												  chain, route.getSegment( position, n ) } );
+					}
+				}
+
+		changed |= improved;
+	}
+
+	return changed;
+}
+
+/**
+ * Riporta sulla soluzione il nuovo percorso di un veicolo.
+ *
+ * @param solution	la soluzione da modificare
+ * @param vehicle	il veicolo
+ * @param route		il suo nuovo percorso
+ * @return	vero, se la soluzione risultante è ammissibile e migliore; altrimenti viene ripristinata
+ */
+bool Solver::commitRoute( Solution* solution, uint vehicle, const Route& route )
+{
+	Solution backup( *solution );
+	route.apply( solution, vehicle );
+
+	// Riscrivendo il veicolo, il servizio dei lati condivisi può passare ad altri
+	bool feasible = *solution > backup;
+	for ( int v = 0; v < M && feasible; v++ )
+		feasible = isFeasible( solution, v );
+
+	if ( !feasible )
+		*solution = Solution( backup );
+
+	return feasible;
+}
+
+/**
+ * Percorre i servizi di ogni veicolo nei versi che minimizzano il costo dei collegamenti,
+ * senza cambiarne l'ordine. Il tempo liberato resta disponibile per servire altri lati.
+ *
+ * @param solution	la soluzione da migliorare
+ * @return	vero, se almeno un veicolo è stato accorciato
+ */
+bool Solver::orientServices( Solution* solution )
+{
+	bool changed = false;
+
+	for ( int v = 0; v < M; v++ )
+	{
+		Route route( *solution, v, graph, depot );
+		Route oriented = route.orient();
+
+		if ( oriented.getCost() < route.getCost() )
+			changed |= commitRoute( solution, v, oriented );
+	}
+
+	return changed;
+}
+
+/**
+ * Riporta sulla soluzione i nuovi percorsi di due veicoli.
+ *
+ * @param solution	la soluzione da modificare
+ * @param routes	i percorsi di tutti i veicoli, aggiornati se la mossa viene tenuta
+ * @param a			il primo veicolo
+ * @param routeA	il suo nuovo percorso
+ * @param b			il secondo veicolo
+ * @param routeB	il suo nuovo percorso
+ * @return	vero, se la soluzione risultante è ammissibile e migliore o più bilanciata; altrimenti viene ripristinata
+ */
+bool Solver::commitRoutes( Solution* solution, vector<Route>* routes, uint a, const Route& routeA, uint b, const Route& routeB )
+{
+	Solution backup( *solution );
+
+	// A parità di soluzione chiedo che il carico sia più bilanciato, ovvero che la somma dei quadrati
+	//  dei carichi diminuisca: i percorsi riletti potrebbero non essere quelli previsti dalla mossa
+	auto balance = [ & ]( const Solution* x ) -> long
+	{
+		long result = 0;
+		for ( int v = 0; v < M; v++ )
+			result += (long)x->getDemand( v ) * x->getDemand( v );
+		return result;
+	};
+	long previous = balance( &backup );
+
+	routeA.apply( solution, a );
+	routeB.apply( solution, b );
+
+	bool feasible = *solution > backup || ( !( backup > *solution ) && balance( solution ) < previous );
+	for ( int v = 0; v < M && feasible; v++ )
+		feasible = isFeasible( solution, v );
+
+	if ( !feasible )
+	{
+		*solution = Solution( backup );
+		return false;
+	}
+
+	// I servizi vanno riletti: i collegamenti potrebbero averne aggiunti
+	( *routes )[ a ] = Route( *solution, a, graph, depot );
+	( *routes )[ b ] = Route( *solution, b, graph, depot );
+
+	return true;
+}
+
+/**
+ * Taglia un giro gigante in al più M percorsi, in tempo lineare.
+ * I lati vengono considerati in ordine e serviti dal veicolo corrente, nel verso più vicino,
+ * se carico e tempo ( compreso il ritorno al deposito ) lo consentono; altrimenti il veicolo
+ * torna al deposito e si passa al successivo, e se nemmeno questo basta il lato viene saltato.
+ * I collegamenti sono i lati diretti del grafo completo: come nella Solution, un collegamento
+ * profittevole mai percorso viene servito, per cui ne conto domanda e profitto.
+ *
+ * @param tour	il giro gigante
+ * @return	la soluzione decodificata
+ */
+Solution Solver::splitTour( const vector<int>& tour )
+{
+	const vector<Edge*>& required = bound.getEdges();
+	Solution result( M, graph );
+
+	// Lati già percorsi da qualcuno, indicizzati con Edge::getId
+	vector<bool> taken( graph.getEdges().size(), false );
+
+	uint vehicle = 0,
+		 last = depot,
+		 time = 0,
+		 load = 0;
+
+	for ( int gene : tour )
+	{
+		Edge* edge = required[ gene ];
+		if ( taken[ edge->getId() ] )
+			continue;
+
+		for ( int attempt = 0; attempt < 2; attempt++ )
+		{
+			// Scelgo il verso ammissibile col collegamento più corto
+			Edge* deadhead = NULL;
+			uint entry = depot,
+				 nextLoad = 0,
+				 nextTime = 0;
+			bool fits = false;
+
+			for ( int direction = 0; direction < 2; direction++ )
+			{
+				uint u = ( direction ? edge->getDst() : edge->getSrc() ),
+					 v = edge->getDst( u );
+				Edge* link = ( last != u ? graph.getEdge( last, u ) : NULL );
+				Edge* back = ( v != depot ? graph.getEdge( v, depot ) : NULL );
+
+				uint newLoad = load + edge->getDemand();
+				if ( link != NULL && link != edge && !taken[ link->getId() ] )
+					newLoad += link->getDemand();
+				// Il ritorno, se ancora libero, verrebbe servito alla chiusura
+				if ( back != NULL && back != edge && back != link && !taken[ back->getId() ] )
+					newLoad += back->getDemand();
+
+				uint newTime = time + graph.getDistance( last, u ) + edge->getCost();
+				if ( newLoad > Q || newTime + graph.getDistance( v, depot ) > tMax )
+					continue;
+
+				if ( !fits || newTime < nextTime )
+				{
+					fits = true;
+					deadhead = link;
+					entry = u;
+					nextTime = newTime;
+					nextLoad = newLoad - ( back != NULL && back != edge && back != link && !taken[ back->getId() ] ?
+										   back->getDemand() : 0 );
 				}
-				else
+			}
+
+			if ( fits )
+			{
+				// Un collegamento coincidente col lato stesso verrebbe percorso due volte
+				if ( deadhead == edge )
+					break;
+
+				if ( deadhead != NULL )
 				{
-					ninjaTurtle = &solver::Solver::mutateSolutionOpen;
-#ifdef DEBUG
-					cerr << "Cambio a open" << endl;
-#endif
+					result.addEdge( deadhead, vehicle );
+					taken[ deadhead->getId() ] = true;
 				}
+				result.addEdge( edge, vehicle );
+				taken[ edge->getId() ] = true;
 
-				exterminate--;
+				last = edge->getDst( entry );
+				time = nextTime;
+				load = nextLoad;
+				break;
 			}
 
-		}while( exterminate > 0 && !mutate );
+			// Il lato non entra: chiudo il veicolo, se ha già servito qualcosa e non è l'ultimo
+			if ( attempt > 0 || time == 0 || vehicle + 1 >= M )
+				break;
 
-		// Teoricamente servirebbe qualcosa di questo tipo
-		// Saremmo in una soluzione inamovibile, per cui sarebbe insensato cercare di continuare a modificarla.
-		if( exterminate <= 0 )
-		{
-#ifdef DEBUG
-			cerr << "Non ho fatto una mazza" << endl;
-#endif
-			return false;
-		}
-		
+			if ( last != depot )
+			{
+				Edge* back = graph.getEdge( last, depot );
+				result.addEdge( back, vehicle );
+				taken[ back->getId() ] = true;
+			}
 
+			vehicle++;
+			last = depot;
+			time = 0;
+			load = 0;
+		}
 	}
 
-	return (uint)solution->size();
+	if ( last != depot )
+		result.addEdge( graph.getEdge( last, depot ), vehicle );
+
+	return result;
 }
 
-bool Solver::mutateSolutionClose( Solution *solution, uint vehicle, int edge )
+/**
+ * Riscrive un giro gigante secondo una soluzione: prima i lati serviti, nell'ordine dei percorsi,
+ * poi quelli non serviti nell'ordine che avevano nel giro di partenza.
+ *
+ * @param solution	la soluzione
+ * @param tour		il giro di partenza
+ * @return	il nuovo giro
+ */
+vector<int> Solver::encodeTour( const Solution& solution, const vector<int>& tour ) const
 {
-	// Estraggo un lato casuale dalla soluzione se non differentemente indicato
-	if( edge == -1 )
-		edge = (uint) rand() % ( solution->size( vehicle ) - 1 );
-	else
-		if( edge == solution->size( vehicle ) - 1 )
-			return false;
-
-	// Se uno dei due lati della chiusura non è rimovibile, non posso agire
-	if ( !isRemovable( solution, vehicle, edge ) || !isRemovable( solution, vehicle, edge + 1 ) )
-		return false;
-
-	uint src = solution->getEdge( vehicle, edge )->getSrc();
-	uint dst = solution->getEdge( vehicle, edge )->getDst();
+	const vector<Edge*>& required = bound.getEdges();
 
-	if( !solution->getDirection( vehicle, edge ) )
-		dst ^= src ^= dst ^= src;
-
-#ifdef DEBUG
-	cerr << "Close " << edge << ": ( " << src << ", " << dst << " ) " << endl;
-#endif
+	// Posizione dei lati in bound.getEdges(), indicizzata con Edge::getId
+	vector<int> gene( graph.getEdges().size(), -1 );
+	for ( int i = 0; i < required.size(); i++ )
+		gene[ required[ i ]->getId() ] = i;
 
-	// Ricavo la destinazione della destinazione dal lato scelto
-	uint final_dst = solution->getEdge( vehicle, edge + 1 )->getDst( dst );
-	Edge* first = graph.getEdge( src, dst );
-	Edge* second = graph.getEdge( dst, final_dst );
+	vector<bool> used( required.size(), false );
+	vector<int> result;
+	for ( int v = 0; v < M; v++ )
+	{
+		Vehicle* aVehicle = solution.getVehicle( v );
+		for ( int i = 0; i < solution.size( v ); i++ )
+		{
+			MetaEdge* edge = solution.getEdge( v, i );
+			int g = gene[ edge->getEdge()->getId() ];
+			if ( g >= 0 && !used[ g ] && edge->isServer( aVehicle ) )
+			{
+				used[ g ] = true;
+				result.push_back( g );
+			}
+		}
+	}
 
-	// Elimino i lati src->dst e dst->final_dst
-	solution->removeEdge( vehicle, edge );
-	solution->removeEdge( vehicle, edge );
+	for ( int g : tour )
+		if ( !used[ g ] )
+			result.push_back( g );
 
-	// Inserisco il lato che unisce src->final_dst
-	bool autoCiclo = src == final_dst;
-	if( !autoCiclo )
-		solution->addEdge( graph.getEdge( src, final_dst ), vehicle, edge );
+	return result;
+}
 
-	// Devo controllare la feasibility per eventuali problemi di domanda
-	if( isFeasible( solution, vehicle ) )
+/**
+ * Incrocio OX: il figlio eredita un tratto casuale del primo genitore nella stessa posizione,
+ * ed i geni rimanenti nell'ordine del secondo, ripartendo dopo il tratto.
+ *
+ * @param first		il primo genitore
+ * @param second	il secondo genitore
+ * @return	il figlio
+ */
+vector<int> Solver::crossTours( const vector<int>& first, const vector<int>& second ) const
+{
+	int n = (int)first.size();
+	if ( n < 2 )
+		return first;
+
+	int begin = rand() % n,
+		end = rand() % n;
+	if ( begin > end )
+		swap( begin, end );
+
+	vector<int> child( n, -1 );
+	vector<bool> used( n, false );
+	for ( int i = begin; i <= end; i++ )
 	{
-#ifdef DEBUG
-		cerr << "Close completato sul lato ( " << src << ", " << dst << " ) ";
-		cerr << "chiuso con ( " << src << " " << final_dst << " ) escludendo il nodo " << dst << endl;
-#endif
-		return true;
+		child[ i ] = first[ i ];
+		used[ first[ i ] ] = true;
 	}
-	else
-	{
-		if ( !autoCiclo )
-			solution->removeEdge( vehicle, edge );
 
-		solution->addEdge( second, vehicle, edge );
-		solution->addEdge( first, vehicle, edge );
+	int position = ( end + 1 ) % n;
+	for ( int i = 0; i < n; i++ )
+	{
+		int g = second[ ( end + 1 + i ) % n ];
+		if ( used[ g ] )
+			continue;
 
+		child[ position ] = g;
+		position = ( position + 1 ) % n;
 	}
 
-	return false;
+	return child;
 }
 
-bool Solver::mutateSolutionOpen( Solution *solution, uint vehicle, int edge )
+/**
+ * Decodifica ed ottimizza i giri, distribuendoli tra THREADS thread.
+ *
+ * @param tours	i giri da valutare
+ * @return	le soluzioni corrispondenti, allocate dinamicamente
+ */
+vector<Solution*> Solver::evaluateTours( const vector< vector<int> >& tours )
 {
-	// Estraggo un lato casuale dalla soluzione se non già indicato
-	if( edge == -1 )
-		edge = (uint) rand() % solution->size( vehicle );
-
-	// Se il lato non è rimovibile, non posso agire
-	if ( !isRemovable( solution, vehicle, edge ) )
-		return false;
+	vector<Solution*> result( tours.size(), NULL );
+	int threads = ( parameters.threads > 0 ? parameters.threads : max( 1, (int)thread::hardware_concurrency() ) );
 
-	uint src = solution->getEdge( vehicle, edge )->getSrc();
-	uint dst = solution->getEdge( vehicle, edge )->getDst();
+	auto work = [ & ]( int worker )
+	{
+		for ( int i = worker; i < tours.size(); i += threads )
+		{
+			Solution solution = splitTour( tours[ i ] );
+			optimizeSolution( &solution );
+			result[ i ] = new Solution( solution );
+		}
+	};
 
-	if( !solution->getDirection( vehicle, edge ) )
-		dst ^= src ^= dst ^= src;
+	vector<thread> workers;
+	for ( int i = 1; i < threads; i++ )
+		workers.push_back( thread( work, i ) );
+	work( 0 );
+	for ( auto& worker : workers )
+		worker.join();
 
-#ifdef DEBUG
-	cerr << "Open " << edge << ": ( " << src << ", " << dst << " ) " << endl;
-#endif
+	return result;
+}
 
-	// Lista di adiacenza del nodo sorgente
-	vector<Edge*> adj = graph.getAdjList( src );
-	// Prendo i nodi adiacenti al lato estratto casualmente
-	bool* edgeTested = (bool*)calloc( adj.size(), sizeof( bool ) );
-	int testables = (int)adj.size();
-	// Dalla lista elimino il nodo dst
-	for( int i = 0; i < adj.size(); i++ )
+/**
+ * @param node	il nodo da estendere
+ * @param dst	il nodo da raggiungere
+ * @return	i candidati del nodo, a cui aggiungo il lato che porta direttamente a dst
+ */
+vector<Edge*> Solver::getCandidates( uint node, uint dst ) const
+{
+	vector<Edge*> result = graph.getCandidates( node );
+	if ( node != dst )
 	{
-		if( adj[ i ]->getDst( src ) == dst )
-		{
-			edgeTested[ i ] = 1;
-			testables--;
-			break;
-		}
+		Edge* edge = graph.getEdge( node, dst );
+		if ( find( result.begin(), result.end(), edge ) == result.end() )
+			result.push_back( edge );
 	}
 
-	while ( testables > 0 )
-	{
-		uint closer;
-		// Cerco un nodo non ancora testato
-		while( edgeTested[ closer = (uint) rand() % adj.size() ] );
-		edgeTested[ closer ] = true;
-		testables--;
+	return result;
+}
 
-		// Prendo il nodo di chiusura corrispondente a closer
-		closer = adj[ closer ]->getDst( src );
+/**
+ * @return	i nodi visitati dal veicolo, a partire dal deposito ( size + 1 elementi )
+ */
+vector<uint> Solver::getVertices( const Solution* solution, uint vehicle ) const
+{
+	vector<uint> vertices( 1, depot );
+	for ( int i = 0; i < solution->size( vehicle ); i++ )
+		vertices.push_back( solution->getEdge( vehicle, i )->getDst( vertices.back() ) );
 
-/*
-#ifdef DEBUG
-		cerr << "Test: " << testables;
-		cerr << ". Ho scelto te: " << closer;
-		cerr << " per aprire ( " << src << ", " << dst << " ) " << endl;
-#endif
-*/
-		// Salvo il lato nel caso in cui lo debba reinserire
-		Edge* removed = graph.getEdge( src, dst );
-		
-		// Rimuovo il lato dalla soluzione
-		solution->removeEdge( vehicle, edge );
-		
+	return vertices;
+}
 
-		// Chiudo la soluzione e verifico se la soluzione è feasible
-		// Inserimento al "contrario" perché l'inserimento viene effettuato prima dell'indice del lato scelto.
-		solution->addEdge( graph.getEdge( closer, dst ), vehicle, edge );
-		solution->addEdge( graph.getEdge( src, closer ), vehicle, edge );
+/**
+ * Selezione a roulette.
+ *
+ * @param weights	i pesi, non negativi
+ * @return	un indice estratto con probabilità proporzionale al suo peso
+ */
+int Solver::roulette( const vector<float>& weights ) const
+{
+	float total = 0;
+	for ( float weight : weights )
+		total += weight;
 
-		// Controllo la feasibilità della nuova soluzione
-		if( isFeasible( solution, vehicle ) )
-		{
-#ifdef DEBUG
-			cerr << "Open completato con nodo " << closer << endl;
-#endif
-			free( edgeTested );
-			return true;
-		}
-		else
-		{
-			// Ripristino la soluzione iniziale
-			solution->removeEdge( vehicle, edge );
-			solution->removeEdge( vehicle, edge );
-			solution->addEdge( removed, vehicle, edge );
-		}
+	float x = total * rand() / RAND_MAX;
+	for ( int i = 0; i < weights.size(); i++ )
+	{
+		x -= weights[ i ];
+		if ( x <= 0 )
+			return i;
 	}
 
-	free( edgeTested );
-	return false;
+	return (int)weights.size() - 1;
 }
 
 int Solver::openSolutionRandom( Solution *solution, uint vehicle, int k, uint* src, uint* dst )
@@ -1072,266 +3034,177 @@ int Solver::openSolutionRandom( Solution *solution, uint vehicle, int k, uint* s
 	return edge; 
 }
 
-bool Solver::closeSolutionRandom( Solution* solution, int vehicle, uint src, uint dst, int k, int edgeIndex )
+/**
+ * Costruttore: prepara la visita in profondità a partire da src, senza toccare la soluzione.
+ *
+ * @param solver	il solver, da cui prendere candidati, grafo e limiti
+ * @param solution	la soluzione col buco da chiudere
+ * @param vehicle	il veicolo
+ * @param src		il nodo da cui parte il buco
+ * @param dst		il nodo in cui termina il buco
+ * @param k			la lunghezza massima di una chiusura
+ * @param edgeIndex	l'indice a cui inserire il primo lato della chiusura
+ */
+Solver::Closures::Closures( const Solver* solver, Solution* solution, int vehicle, uint src, uint dst, int k, int edgeIndex ):
+	solver( solver ), solution( solution ), vehicle( vehicle ), edgeIndex( edgeIndex ), dst( dst ), k( k ),
+	time( 1, solution->getCost( vehicle ) ), empty( src == dst ), expanded( 0 )
 {
-	srand( (uint)time( NULL ) );
-	/*
-#ifdef DEBUG
-	cerr << "iter: " << k << "\tindice: " << edgeIndex << endl;
-#endif
-
-	// Piede della ricorsione: se src == dst ho chiuso ( con probabilità => ammetto ulteriori cicli )
-	if ( src == dst && ( ( (float)rand() / RAND_MAX ) <= P_ACCEPT || k <= 1 ) )
-		return true;
-
-	// Non posso aggiungere altri lati
-	if ( k == 0 )
-		return false;
+	if ( k > 0 )
+		stack.push_back( { src, solver->getCandidates( src, dst ), 0 } );
+}
 
-	// Controllo se devo chiudere il ciclo direttamente o meno
-	if ( ( k == 1 ) && ( (float)rand() / RAND_MAX ) <= P_CLOSE )
+/**
+ * Distruttore: toglie dalla soluzione l'ultima chiusura restituita.
+ */
+Solver::Closures::~Closures()
+{
+	while ( path.size() )
 	{
-		solution->addEdge( graph.getEdge( src, dst ), vehicle, edgeIndex );
-
-		if( !isFeasible( solution, vehicle ) )
-		{
-			solution->removeEdge( vehicle, edgeIndex );
-			return false;
-		}
+		solution->removeEdge( vehicle, edgeIndex + (int)path.size() - 1 );
+		path.pop_back();
+	}
+}
 
+/**
+ * Passa alla chiusura successiva.
+ * Un lato viene scartato appena il veicolo non potrebbe più tornare a dst in tempo
+ *  o appena supera la capacità: i suoi prolungamenti non vengono mai generati.
+ *
+ * @return	falso, se le chiusure sono finite
+ */
+bool Solver::Closures::next()
+{
+	if ( empty )
+	{
+		empty = false;
 		return true;
 	}
 
-	// Inizio con la chiusura della soluzione, partendo dal nodo sorgente, ovvero dove ha inizio il buco
-	vector <Edge*> edges = graph.getAdjList( src );
-	bool* tried = (bool*)calloc( edges.size(), sizeof( bool ) );
-	
-	// TODO: decidere se 1 o proporzionale o tutto o cosa.
-	uint tries = ceil( (float)edges.size() / 10 );//(uint)edges.size();
-	
-	while ( tries-- > 0 )
-	{
-		// Casualmente prelevo un nodo da inserire nella soluzione che non sia già stato provato
-		uint v;
-		while ( tried[ v = ( rand() % edges.size() ) ] );
-		tried[ v ] = true;
-		Edge* victim = edges[ v ];
-		solution->addEdge( victim, vehicle, edgeIndex );
-		
-#ifdef DEBUG
-		cerr << "Lato selezionato: (" << victim->getSrc() << "," << victim->getDst() << ")" << endl;
-#endif
-		
-		// Controllo subito se il lato inserito mi porta ad una situazione di soluzione non feasible
-		// Se i miei figli non trovano alcun lato buono,
-		//  allora elimino il lato inserito fino a tornare alla soluzione iniziale
-		if( !isFeasible( solution, vehicle ) ||
-		    !closeSolutionRandom( solution, vehicle, victim->getDst( src ), dst, k - 1, edgeIndex + 1 ) )
-		{
-#ifdef DEBUG
-			cerr << "Unfeasible: k = " << k << " tries = " << tries << " => " << solution->toString();
-#endif
-			solution->removeEdge( vehicle, edgeIndex );
-			continue; // return false ?
-		}
-		else
-		{
-			free( tried );
-			return true;
-		}
-	}
-	
-	// Tento (con probabilità) un'ultima chiusura secca se tutte le precedenti sono andate male.
-	if ( ( (float)rand() / RAND_MAX ) <= P_CLOSE )
+	while ( stack.size() )
 	{
-#ifdef DEBUG
-		cerr << "Lancio una moneta. " << endl;
-#endif
-		if ( src == dst )
+		Frame& frame = stack.back();
+
+		// Tolgo il lato messo in precedenza da questo livello
+		if ( path.size() == stack.size() )
 		{
-#ifdef DEBUG
-			cerr << "Non dovevo fare niente. " << endl;
-#endif
-			free( tried );
-			return true;
+			solution->removeEdge( vehicle, edgeIndex + (int)path.size() - 1 );
+			path.pop_back();
+			time.pop_back();
 		}
-		
-		solution->addEdge( graph.getEdge( src, dst ), vehicle, edgeIndex );
-		
-		if( isFeasible( solution, vehicle ) )
+
+		if ( frame.next == frame.candidates.size() )
 		{
-#ifdef DEBUG
-			cerr << "Ce l'ho fatta. " << endl;
-#endif
-			free( tried );
-			return true;
+			stack.pop_back();
+			continue;
 		}
-		
-		solution->removeEdge( vehicle, edgeIndex );
+
+		Edge* edge = frame.candidates[ frame.next++ ];
+		uint node = edge->getDst( frame.node ),
+			 cost = time.back() + edge->getCost();
+		expanded++;
+
+		if ( cost + solver->graph.getDistance( node, dst ) > solver->tMax )
+			continue;
+
+		solution->addEdge( edge, vehicle, edgeIndex + (int)path.size() );
+		path.push_back( edge );
+		time.push_back( cost );
+
+		// La domanda cambia solo coi lati che ne hanno: il lato viene tolto al giro successivo
+		if ( edge->getDemand() > 0 && !solver->isFeasible( solution, vehicle ) )
+			continue;
+
+		if ( path.size() < k )
+			stack.push_back( { node, solver->getCandidates( node, dst ), 0 } );
+
+		if ( node == dst )
+			return true;
 	}
-	
-#ifdef DEBUG
-	cerr << "Mi arrendo. " << endl;
-#endif
 
-	free( tried );
-	return false;
-*/
-	
+	return false;
+}
+
+/**
+ * @return	i lati della chiusura corrente, da src a dst
+ */
+const vector<Edge*>& Solver::Closures::getPath() const
+{
+	return path;
+}
+
+/**
+ * @return	il numero di lati provati finora
+ */
+long Solver::Closures::getExpanded() const
+{
+	return expanded;
+}
+
+bool Solver::closeSolutionRandom( Solution* solution, int vehicle, uint src, uint dst, int k, int edgeIndex )
+{
+	srand( (uint)time( NULL ) );
+
 	/**
-	 * Versione tonta di Bellman-Ford
-	 * 	Cerco tutti i percorsi di lunghezza al più k che conducano a dst:
-	 *		Se sorgente e destinazione coincidono, aggiungo la soluzione vuota alle soluzioni.
-	 *		Ogni volta che trovo un percorso feasible, lo aggiungo a quelli da estendere.
-	 *		Se il percorso termina su dst, lo aggiungo al vettore delle soluzioni.
+	 * Estrazione a serbatoio tra le chiusure generate:
+	 *	la i-esima chiusura sostituisce quella scelta con probabilità 1 / i, per cui alla fine
+	 *	ognuna ha la stessa probabilità di essere scelta senza doverle tenere tutte in memoria.
+	 *	Ogni CLOSURE_BUDGET lati provati mi fermo con probabilità P_CLOSE, se ho già una chiusura.
 	 */
-	vector< vector< list<Edge*> > > paths = vector< vector< list<Edge*> > >( graph.size() );
-	vector< list<Edge*> > sol = vector< list<Edge*> >();
-	uint pathsFound = 0;
+	vector<Edge*> closure;
+	long found = 0,
+		 checkpoint = CLOSURE_BUDGET;
 
-	// Inizializzo i percorsi:
-	//	Parto dal nodo sorgente e guardo tutte le adiacenze feasible.
-	vector<Edge*> edges = graph.getAdjList( src );
-	for ( Edge* edge : edges )
 	{
-		// "Peso" il lato nel caso in cui questo venga inserito nella soluzione
-		list<Edge*> initPath;
-		initPath.push_back( edge );
-		
-		solution->addEdge( edge, vehicle, edgeIndex );
-
-		if ( isFeasible( solution, vehicle ) )
+		Closures closures( this, solution, vehicle, src, dst, k, edgeIndex );
+		while ( closures.next() )
 		{
-			pathsFound++;
-			paths[ edge->getDst( src ) ].push_back( initPath );
-
-			if ( edge->getDst( src ) == dst )
-				sol.push_back( initPath );
-		}
+			if ( rand() % ++found == 0 )
+				closure = closures.getPath();
 
-		solution->removeEdge( vehicle, edgeIndex );
-	}
-	// Soluzione vuota (~autopercorso gratutio)
-	if ( src == dst )
-		sol.push_back( list<Edge*>() );
-	
-#ifdef DEBUG
-	cerr << "BOZO Inizializzazione: " << endl;
-	for ( int i = 0; i < graph.size(); i++ )
-	{
-		cerr << i << "] ";
-		if ( !paths[ i ].empty() )
-		{
-			for ( auto edge : paths[ i ].front() )
-				cerr << "( " << edge->getSrc() << ", " << edge->getDst() << " ) " << endl;
-		}
-		else
-			cerr << "vuoto" << endl;
-	}
-#endif
-	
-	// Lunghezza massima: k => itero ancora k - 1 volte ( la prima è sopra )
-	for ( int i = 0; i < k - 1; i++ )
-	{
-		// Ad ogni iterazione analizzo tutti i percorsi trovati, suddivisi per nodo finale
-		for ( int attuale = 0; attuale < graph.size(); attuale++ )
-		{
-#ifdef DEBUG
-			cerr << attuale << ", percorsi: " << pathsFound << endl;
-#endif
-			// Per ogni nodo finale, analizzo tutti i percorsi trovati dalla precedente iterazione
-			while ( paths[ attuale ].size() )
+			if ( closures.getExpanded() >= checkpoint )
 			{
-				list<Edge*> actSol = paths[ attuale ].back();
-				
-				edges = graph.getAdjList( attuale );
-				for ( Edge* edge : edges )
-				{
-//					// Evito di iterare sullo stesso lato
-//					uint previous = src;
-//					bool inSolution = false;
-//					for ( auto it = actSol.begin(); it != actSol.end(); ++it )
-//					{
-//						if ( ( attuale == previous && edge->getDst( attuale ) == (*it)->getDst( previous ) ) ||
-//							 ( attuale == (*it)->getDst( previous ) && edge->getDst( attuale ) == previous ) )
-//						{
-//							inSolution = true;
-//							break;
-//						}
-//						
-//						previous = edge->getDst( previous );
-//					}
-//					if ( inSolution )
-//						continue;
-				 
-					list<Edge*> newSol( actSol );
-					newSol.push_back( edge );
-
-					for ( auto it = newSol.rbegin(); it != newSol.rend(); ++it )
-						solution->addEdge( *it, vehicle, edgeIndex );
-					
-					if ( isFeasible( solution, vehicle ) )
-					{
-						pathsFound++;
-						paths[ edge->getDst( attuale ) ].push_back( newSol );
-
-						if ( edge->getDst( src ) == dst )
-							sol.push_back( newSol );
-						
-						// Faccio un'estrazione ogni tot percorsi analizzati
-						if ( pathsFound == 2000 )
-						{
-							pathsFound = 0;
-							if ( (float)rand() / RAND_MAX < P_CLOSE )
-							{
-								list<Edge*> closure = sol[ rand() % sol.size() ];
-#ifdef DEBUG
-								cerr << endl << "BOZO Fine prematura: " << endl;
-								for ( auto edge : sol.back() )
-									cerr << "( " << edge->getSrc() << ", " << edge->getDst() << " ) ";
-								cerr << endl;
-#endif
-								for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
-									solution->addEdge( *it, vehicle, edgeIndex );
-								
-								return true;
-							}
-						}
-					}
-
-					for ( int i = 0; i < newSol.size(); i++ )
-						solution->removeEdge( vehicle, edgeIndex );
-				}
-
-				// Rimuovo il percorso analizzato
-				paths[ attuale ].pop_back();
+				checkpoint = closures.getExpanded() + CLOSURE_BUDGET;
+				if ( (float)rand() / RAND_MAX < parameters.pClose )
+					break;
 			}
 		}
-#ifdef DEBUG
-		cerr << "Trovati " << sol.size() << " percorsi." << endl;
-#endif
 	}
-	
-#ifdef DEBUG
-	cerr << endl << "BOZO Fine: " << endl;
-#endif
 
-	// Ritorno un percorso a caso
-	if ( sol.size() )
-	{
-		list<Edge*> closure = sol[ rand() % sol.size() ];
 #ifdef DEBUG
-		for ( auto edge : sol.back() )
-			cerr << "( " << edge->getSrc() << ", " << edge->getDst() << " ) ";
-		cerr << endl;
+	cerr << "Trovati " << found << " percorsi." << endl;
 #endif
-		for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
-			solution->addEdge( *it, vehicle, edgeIndex );
 
-		return true;
-	}
-	else
+	if ( !found )
 		return false;
+
+	for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
+		solution->addEdge( *it, vehicle, edgeIndex );
+
+	return true;
+}
+
+/**
+ * Chiusura di primo miglioramento: prova le chiusure non vuote lunghe al più k lati una alla volta
+ * e si ferma alla prima che rende la soluzione migliore di target, senza generare le altre.
+ * Dopo CLOSURE_BUDGET lati provati si arrende. La soluzione torna comunque com'era.
+ *
+ * @param solution	la soluzione col buco da chiudere
+ * @param vehicle	il veicolo
+ * @param src		il nodo da cui parte il buco
+ * @param dst		il nodo in cui termina il buco
+ * @param k			la lunghezza massima di una chiusura
+ * @param edgeIndex	l'indice a cui inserire il primo lato della chiusura
+ * @param target	la soluzione da migliorare
+ * @return	i lati della chiusura, nessuno se non ne ho trovata una migliorante
+ */
+list<Edge*> Solver::closeSolutionFirst( Solution* solution, int vehicle, uint src, uint dst, int k, int edgeIndex, const Solution& target )
+{
+	Closures closures( this, solution, vehicle, src, dst, k, edgeIndex );
+	while ( closures.getExpanded() < CLOSURE_BUDGET && closures.next() )
+		if ( closures.getPath().size() && *solution > target )
+			return list<Edge*>( closures.getPath().begin(), closures.getPath().end() );
+
+	return list<Edge*>();
 }
 
 list<Edge*> Solver::closeSolutionDijkstra( Solution solution, int vehicle, uint src, uint dst, int edgeIndex )
@@ -1353,7 +3226,7 @@ list<Edge*> Solver::closeSolutionDijkstra( Solution solution, int vehicle, uint
 	vector< list< list<Edge*> > > sol = vector< list< list<Edge*> > >( graph.size() );
 	vector< list< int* > > val = vector< list< int* > >( graph.size() );	// P, T, D
 	
-	vector<Edge*> edges = graph.getAdjList( src );
+	vector<Edge*> edges = getCandidates( src, dst );
 	for ( Edge* edge : edges )
 	{
 		// "Peso" il lato nel caso in cui questo venga inserito nella soluzione
@@ -1414,7 +3287,7 @@ list<Edge*> Solver::closeSolutionDijkstra( Solution solution, int vehicle, uint
 				  ++actSol )
 			{
 				unfeasible = false;
-				edges = graph.getAdjList( attuale );
+				edges = getCandidates( attuale, dst );
 				for ( Edge* edge : edges )
 				{
 //					// Teoricamente dovrei iterare solo sui NODI non ancora in soluzione..
@@ -1535,34 +3408,52 @@ Solution Solver::solve( string method, int repetition )
 			output_file << method << " " << M << endl;
 	}
 
-	// A seconda del metodo richiesto, calcolo la soluzione in modi diversi.
-	if( !method.compare( "VNS" ) )
-		currentSolution = vns( N_ITER, currentSolution );
-	else
+	// Parto dalla costruzione per risparmi, se migliore di quella greedy
+	if ( parameters.savings )
 	{
-		if( !method.compare( "VND" ) )
-			currentSolution = vnd( N_ITER, currentSolution );
-		else
-		{
-			if( !method.compare( "VNASD" ) )
-				currentSolution = vnasd( N_ITER, currentSolution, repetition );
-			else
-			{
-				if( !method.compare( "VNAASD" ) )
-					currentSolution = vnaasd( N_ITER, currentSolution, repetition );
-				else
-				{
-					if ( !method.compare( "BEL" ) )
-						currentSolution = justBellman();
-				}
-			}
-		}
+		Solution savings = createSavingsSolution();
+		if ( savings > currentSolution )
+			currentSolution = savings;
 	}
 
+	// Parto dalla migliore di GRASP_STARTS costruzioni randomizzate
+	if ( parameters.graspStarts > 0 && method.compare( "GRASP" ) )
+		currentSolution = grasp( parameters.graspStarts, currentSolution );
+
+	// A seconda del metodo richiesto, calcolo la soluzione in modi diversi.
+	if( !method.compare( "VNS" ) )
+		currentSolution = vns( parameters.nIter, currentSolution );
+	else if( !method.compare( "VND" ) )
+		currentSolution = vnd( parameters.nIter, currentSolution );
+	else if( !method.compare( "VNASD" ) )
+		currentSolution = vnasd( parameters.nIter, currentSolution, repetition );
+	else if( !method.compare( "VNAASD" ) )
+		currentSolution = vnaasd( parameters.nIter, currentSolution, repetition );
+	else if ( !method.compare( "BEL" ) )
+		currentSolution = justBellman();
+	else if ( !method.compare( "EXACT" ) )
+		currentSolution = exact( currentSolution );
+	else if ( !method.compare( "TS" ) )
+		currentSolution = tabuSearch( parameters.nIter, currentSolution );
+	else if ( !method.compare( "ALNS" ) )
+		currentSolution = alns( parameters.nIter, currentSolution );
+	else if ( !method.compare( "MA" ) )
+		currentSolution = memetic( parameters.nIter, currentSolution );
+	else if ( !method.compare( "GRASP" ) )
+		currentSolution = grasp( parameters.nIter, currentSolution );
+
+	// Ricombino i percorsi raccolti da VNS e VND
+	currentSolution = recombineRoutes( currentSolution );
+
+	// Ricombino le soluzioni d'élite raccolte dalla ricerca
+	if ( parameters.relink )
+		currentSolution = pathRelinking( currentSolution );
+
 	for ( int i = 0; i < M; i++ )
 		if ( !isFeasible( &currentSolution, i ) )
 			throw 3;
 	
+	reportGap( &currentSolution );
 
 #ifdef DEBUG
 	cerr << "Solve" << currentSolution.toString();
@@ -1575,22 +3466,87 @@ bool Solver::isFeasible( const Solution* solution, int vehicle ) const
 	return	solution->getDemand( vehicle ) <= Q && solution->getCost( vehicle ) <= tMax;
 }
 
+/**
+ * Cerca l'impronta della soluzione tra quelle già cercate e, se manca, la ricorda.
+ *
+ * @param solution	la soluzione su cui si sta per fare la ricerca locale
+ * @return	vero, se la soluzione è già stata cercata
+ */
+bool Solver::markVisited( const Solution& solution )
+{
+	if ( parameters.visited <= 0 )
+		return false;
+
+	fingerprint key = solution.getHash();
+	visitedLookups++;
+	if ( visited.count( key ) )
+	{
+		visitedHits++;
+		return true;
+	}
+
+	visited.insert( key );
+	visitedOrder.push_back( key );
+	if ( visitedOrder.size() > parameters.visited )
+	{
+		visited.erase( visitedOrder.front() );
+		visitedOrder.pop_front();
+	}
+
+	return false;
+}
+
+/**
+ * Stampa su stderr quante ricerche locali sono state saltate perché già fatte.
+ */
+void Solver::reportVisited() const
+{
+	if ( parameters.visited > 0 )
+		cerr << "Soluzioni già cercate: " << visitedHits << " su " << visitedLookups << endl;
+}
+
 bool Solver::isRemovable( const Solution* solution, int vehicle, int index ) const
 {
 	Vehicle* tempVehicle = solution->getVehicle( vehicle );
 	MetaEdge* tempMeta = solution->getEdge( vehicle, index );
-	
-	// Se non è la prima volta per cui passo da questo lato, è certamente rimovibile
-	for ( int i = 0; i < index; i++ )
-		if ( *solution->getEdge( vehicle, i ) == *tempMeta )
-			return true;
+	uint edgeId = tempMeta->getEdge()->getId();
 
 	// Il lato NON è rimovibile se io lo servo e non sono l'unico a passarci.
-	// Ed è la prima volta che ci passo! (vedi sopra)
 	// Questo è vero assumendo un bin packing fatto precedentemente
-	return !( tempMeta->getDemand() &&
-			  tempMeta->isServer( tempVehicle ) &&
-			  tempMeta->getTaken() > 1 );
+	if ( !tempMeta->getDemand() || !tempVehicle->getServed()[ edgeId ] ||
+		 tempMeta->getTakers().size() == tempVehicle->getPassages( tempMeta ) )
+		return true;
+
+	// Ed è la prima volta che ci passo: se ci passo una volta sola, lo è di certo
+	if ( tempVehicle->getPassages( tempMeta ) > 1 )
+		for ( int i = 0; i < index; i++ )
+			if ( *solution->getEdge( vehicle, i ) == *tempMeta )
+				return true;
+
+	return false;
+}
+
+/**
+ * Stampa su stderr il profitto della soluzione, il limite superiore ed il gap relativo.
+ *
+ * @param solution	la soluzione di cui riportare il gap
+ */
+void Solver::reportGap( const Solution* solution ) const
+{
+	cerr << "Profitto: " << solution->getProfit();
+	cerr << " Bound: " << bound.getUpperBound();
+	cerr << " Gap: " << 100 * bound.getGap( solution->getProfit() ) << "%" << endl;
+}
+
+/**
+ * Controlla se la soluzione è abbastanza vicina al limite superiore da poter fermare la ricerca.
+ *
+ * @param solution	la soluzione da controllare
+ * @return	vero, se il gap è non superiore alla soglia GAP
+ */
+bool Solver::isGapClosed( const Solution* solution ) const
+{
+	return bound.getGap( solution->getProfit() ) <= parameters.gap;
 }
 
 bool Solver::setOutputFile( string filename )
@@ -1621,11 +3577,20 @@ void Solver::printToFile( Solution* solution )
 	return;
 }
 
+/**
+ * Cede ad altri veicoli che li attraversano i servizi del veicolo indicato, liberandone la capacità.
+ * Le capacità residue degli altri veicoli vengono calcolate una volta sola ed aggiornate ad ogni cessione.
+ * Prima provo un best fit decreasing: ogni lato, dal più oneroso, va al veicolo a cui lascia meno capacità.
+ * Se qualche lato resta al veicolo e i lati cedibili sono al più PACKING_EXACT_EDGES, cerco l'assegnamento
+ *  che cede più domanda con una programmazione dinamica sui sottoinsiemi dei lati:
+ *  per ogni veicolo, gli insiemi di lati che lui ed i precedenti possono prendere.
+ *
+ * @param solution	la soluzione da modificare
+ * @param vehicle	il veicolo da alleggerire
+ * @return	il numero di lati ceduti
+ */
 int Solver::mrBeanBeanBinPacking( Solution* solution, int vehicle )
 {
-	// Il metodo cerca di ottimizzare la domanda del veicolo passato come parametro,
-	// cercando di spostare la domanda su altri veicoli su lati comuni.
-
 #ifdef DEBUG
 	cerr << "MrBean" << endl;
 	cerr << "Soluzione: " << solution->toString() << endl;
@@ -1634,65 +3599,156 @@ int Solver::mrBeanBeanBinPacking( Solution* solution, int vehicle )
 
 	Vehicle* optimizationVehicle = solution->getVehicle( vehicle );
 
-	set<MetaEdge*> served;
-	for ( int i = 0; i < solution->size( vehicle ); i++ )
+	// Lati serviti dal veicolo che qualcun altro attraversa
+	boost::dynamic_bitset<> served = optimizationVehicle->getServed() & solution->getShared();
+	if ( served.none() )
+		return 0;
+
+	const vector<Edge*>& edges = graph.getEdges();
+	vector<MetaEdge*> toServe;
+	for ( size_t i = served.find_first(); i != boost::dynamic_bitset<>::npos; i = served.find_next( i ) )
+		if ( edges[ i ]->getDemand() > 0 )
+			toServe.push_back( solution->getMetaEdge( edges[ i ] ) );
+
+	// Ordino i lati trovati in ordine decrescente di domanda, per il best fit decreasing
+	sort( toServe.begin(), toServe.end(), solution->comparePacking );
+
+	// Per ogni lato, i veicoli a cui può essere ceduto
+	vector< vector<uint> > candidates( toServe.size() );
+	vector<int> residual( M, 0 );
+	vector<bool> computed( M, false );
+	for ( int i = 0; i < toServe.size(); i++ )
+		for ( const Vehicle* taker : toServe[ i ]->getTakers() )
+		{
+			uint v = solution->getVehicleIndex( taker );
+			if ( v == vehicle || find( candidates[ i ].begin(), candidates[ i ].end(), v ) != candidates[ i ].end() )
+				continue;
+
+			candidates[ i ].push_back( v );
+			if ( !computed[ v ] )
+			{
+				residual[ v ] = (int)Q - (int)solution->getDemand( v );
+				computed[ v ] = true;
+			}
+		}
+
+	// Best fit decreasing
+	vector<int> assignment( toServe.size(), -1 );
+	int moved = 0;
+	for ( int i = 0; i < toServe.size(); i++ )
 	{
-		MetaEdge* edge = solution->getEdge( vehicle, i );
+		int demand = toServe[ i ]->getDemand(),
+			best = -1;
+		for ( uint v : candidates[ i ] )
+			if ( residual[ v ] >= demand && ( best == -1 || residual[ v ] < residual[ best ] ) )
+				best = v;
 
-		if ( edge->getProfit() > 0 && edge->isServer( optimizationVehicle ) )
-			served.insert( edge );
+		if ( best != -1 )
+		{
+			assignment[ i ] = best;
+			residual[ best ] -= demand;
+			moved++;
+		}
 	}
 
-	// Ordino i lati trovati in ordine decrescente. Questo rende l'algoritmo First Fit Decreasing.
-	vector<MetaEdge*> toServe( served.begin(), served.end() );
-	sort( toServe.begin(), toServe.end(), solution->comparePacking );
-	
-#ifdef DEBUG
-	cerr << "Lati serviti ordinati:" << endl;
-	for ( auto it = toServe.begin(); it != toServe.end(); ++it )
-		cerr << "( " << (*it)->getSrc() << " " << (*it)->getDst() << " ) " << (*it)->getDemand() << endl;
-#endif
-	
-	int swaps = 0;
-	// Ciclo sull'intera soluzione del veicolo
-	for ( auto it = toServe.begin(); it != toServe.end(); ++it )
+	// Assegnamento esatto, se il best fit non ha ceduto tutto e i lati sono pochi
+	int n = (int)toServe.size();
+	if ( moved < n && n <= PACKING_EXACT_EDGES )
 	{
-		// Prendo i veicoli che passano dal lato
-		vector<const Vehicle*> takers = (*it)->getTakers();
+		// Ripristino le capacità residue precedenti al best fit
+		for ( int i = 0; i < n; i++ )
+			if ( assignment[ i ] != -1 )
+				residual[ assignment[ i ] ] += toServe[ i ]->getDemand();
+
+		uint subsets = 1 << n;
+		vector<int> demand( subsets, 0 );
+		for ( uint mask = 1; mask < subsets; mask++ )
+		{
+			int i = __builtin_ctz( mask );
+			demand[ mask ] = demand[ mask & ( mask - 1 ) ] + toServe[ i ]->getDemand();
+		}
 
-		// Ciclo sui takers per cercare di attribuire la domanda ad un altro veicolo
-		for( int j = 0; j < takers.size(); j++ )
+		// reached[ v ][ S ] indica l'insieme raggiunto prima di dare a v i lati di S che non vi appartengono,
+		//  -1 se S non è raggiungibile coi veicoli fino a v
+		vector<int> reached( subsets, -1 );
+		reached[ 0 ] = 0;
+		vector< vector<int> > layers;
+		vector<uint> layerVehicles;
+		for ( uint v = 0; v < M; v++ )
 		{
-			if( takers[ j ] != solution->getVehicle( vehicle ) )
+			if ( !computed[ v ] )
+				continue;
+
+			uint takeable = 0;
+			for ( int i = 0; i < n; i++ )
+				if ( find( candidates[ i ].begin(), candidates[ i ].end(), v ) != candidates[ i ].end() )
+					takeable |= 1 << i;
+
+			vector<int> next( subsets, -1 );
+			for ( uint mask = 0; mask < subsets; mask++ )
 			{
-				// Unsetto il veicolo da ottimizzare come taker
-				(*it)->setServer( takers[ j ] );
-				// Controllo se questo spostamento lascia la soluzione feasible
-				if( isFeasible( solution, solution->getVehicleIndex( takers[ j ] ) ) )
+				if ( reached[ mask ] == -1 )
+					continue;
+
+				// Tutti i sottoinsiemi dei lati liberi che v può ancora prendere
+				uint available = takeable & ~mask;
+				for ( uint taken = available; ; taken = ( taken - 1 ) & available )
 				{
-					swaps++;
-#ifdef DEBUG
-					cerr << "Scambio fatto con successo!" << endl;
-#endif
-					break;
+					if ( ( !taken || demand[ taken ] <= residual[ v ] ) && next[ mask | taken ] == -1 )
+						next[ mask | taken ] = mask;
+
+					if ( !taken )
+						break;
 				}
-				else
+			}
+
+			layers.push_back( next );
+			layerVehicles.push_back( v );
+			reached = next;
+		}
+
+		uint best = 0;
+		for ( uint mask = 0; mask < subsets; mask++ )
+			if ( reached[ mask ] != -1 && demand[ mask ] > demand[ best ] )
+				best = mask;
+
+		// Risalgo gli strati per sapere a chi va ogni lato
+		if ( demand[ best ] > demand[ 0 ] )
+		{
+			int bestFitDemand = 0;
+			for ( int i = 0; i < n; i++ )
+				if ( assignment[ i ] != -1 )
+					bestFitDemand += toServe[ i ]->getDemand();
+
+			if ( demand[ best ] > bestFitDemand )
+			{
+				assignment.assign( n, -1 );
+				moved = 0;
+				uint mask = best;
+				for ( int l = (int)layers.size() - 1; l >= 0; l-- )
 				{
-					(*it)->setServer( optimizationVehicle );
-#ifdef DEBUG
-					cerr << "Non ha funzionato, ripristino" << endl;
-#endif
+					uint previous = layers[ l ][ mask ];
+					for ( int i = 0; i < n; i++ )
+						if ( ( mask & ~previous ) & ( 1 << i ) )
+						{
+							assignment[ i ] = layerVehicles[ l ];
+							moved++;
+						}
+					mask = previous;
 				}
-
 			}
 		}
 	}
 
+	for ( int i = 0; i < n; i++ )
+		if ( assignment[ i ] != -1 )
+			toServe[ i ]->setServer( solution->getVehicle( assignment[ i ] ) );
+
 #ifdef DEBUG
-	cerr << "Swaps, lati ottimizzati: " << swaps << endl;
+	cerr << "Swaps, lati ottimizzati: " << moved << endl;
 #endif
 
-	return swaps;
+	return moved;
 }
 
 void Solver::cleanVehicle( Solution* solution, int vehicle )
@@ -1767,6 +3823,15 @@ void Solver::cleanVehicle( Solution* solution, int vehicle )
 
 void Solver::optimizeSolution( Solution* solution )
 {
+	// Ribilancio i servizi tra i veicoli ed accorcio i singoli percorsi,
+	//  poi uso tempo e capacità liberati per servire altri lati
+	bool shortened = interRouteSearch( solution );
+	for ( int v = 0; v < M; v++ )
+		shortened |= intraRouteSearch( solution, v );
+	shortened |= orientServices( solution );
+	if ( shortened && parameters.insertion )
+		insertProfitable( solution, 0 );
+
 	for ( int v = 0; v < M; v++ )
 	{
 		// Cerco di ottimizzare il veicolo appena shakerato
@@ -1780,99 +3845,131 @@ void Solver::optimizeSolution( Solution* solution )
 		// Se il veicolo e` vuoto, lo genero in modo greedy (o bellman?)
 		if ( solution->size( v ) )
 		{
-			uint previous = depot;
-			uint next;
-			for ( int i = 0; i < solution->size( v ); i++ )
+			// Bit "look" delle posizioni ( DONT_LOOK ): dopo il primo passaggio, riapro buchi solo attorno
+			//  ai tratti cambiati da una chiusura migliorante. Ripeto finché un passaggio migliora il veicolo;
+			//  con FIRST_IMPROVEMENT il passaggio ricomincia dal primo lato ad ogni miglioramento.
+			vector<bool> look( solution->size( v ), true );
+			bool improved = true;
+			while ( improved )
 			{
+				improved = false;
+				uint previous = depot;
+				uint next;
+				for ( int i = 0; i < solution->size( v ); i++ )
+				{
+					if ( parameters.dontLook && !look[ i ] )
+					{
+						previous = solution->getEdge( v, i )->getDst( previous );
+						continue;
+					}
+					look[ i ] = false;
+
 #ifdef DEBUG
-				cerr << "Lavoro sul veicolo " << v << " lato " << i;
-				cerr << " ( " << solution->getEdge( v, i )->getSrc() << " " << solution->getEdge( v, i )->getDst() << " ) " << endl;
-				cerr << "Parto da: " << solution->toString();
+					cerr << "Lavoro sul veicolo " << v << " lato " << i;
+					cerr << " ( " << solution->getEdge( v, i )->getSrc() << " " << solution->getEdge( v, i )->getDst() << " ) " << endl;
+					cerr << "Parto da: " << solution->toString();
 #endif
-				// Elimino almeno un lato
-				list <Edge*> removedEdges;
-				bool wasServer;
+					// Elimino almeno un lato
+					list <Edge*> removedEdges;
 
-				Vehicle* tempVehicle = solution->getVehicle( v );
+					uint profit = solution->getProfit( v ),
+						 cost = solution->getCost( v );
 
-				MetaEdge* tempMeta = solution->getEdge( v, i );
-				wasServer = tempMeta->isServer( tempVehicle );
-				// Pro thinking:
-				// Se MrBean non è riuscito a riassegnare questo lato ad altri veicoli ed io non sono l'unico che lo attraversa,
-				// è inutile cercare di toglierlo dalla soluzione in quanto renderebbe infeasible un altro veicolo, per cui salto.
-				if( !isRemovable( solution, v, i ) )
-				{
+					MetaEdge* tempMeta = solution->getEdge( v, i );
+					// Pro thinking:
+					// Se MrBean non è riuscito a riassegnare questo lato ad altri veicoli ed io non sono l'unico che lo attraversa,
+					// è inutile cercare di toglierlo dalla soluzione in quanto renderebbe infeasible un altro veicolo, per cui salto.
+					if( !isRemovable( solution, v, i ) )
+					{
 #ifdef DEBUG
-					cerr << "Il lato " << i << " non è rimovibile. Passo al lato successivo." << endl;
+						cerr << "Il lato " << i << " non è rimovibile. Passo al lato successivo." << endl;
 #endif
-					previous = tempMeta->getDst( previous );
-					continue;
-				}
+						previous = tempMeta->getDst( previous );
+						continue;
+					}
 
-				removedEdges.push_back( tempMeta->getEdge() );
+					removedEdges.push_back( tempMeta->getEdge() );
 
-				solution->removeEdge( v, i );
-				next = tempMeta->getDst( previous );
+					solution->removeEdge( v, i );
+					next = tempMeta->getDst( previous );
 
-				// Elimino lati dalla soluzione fintanto che questi non ne aumentano il profitto e fintanto che sono presenti nella soluzione
-				while( i < solution->size( v ) && isRemovable( solution, v, i ) )
-				{
-					// Calcolo la differenza di profitto che abbiamo nel togliere un lato alla soluzione
-					int diffProfit = solution->getProfit( v );
+					// Elimino lati dalla soluzione fintanto che questi non ne aumentano il profitto e fintanto che sono presenti nella soluzione
+					while( i < solution->size( v ) && isRemovable( solution, v, i ) )
+					{
+						// Calcolo la differenza di profitto che abbiamo nel togliere un lato alla soluzione
+						int diffProfit = solution->getProfit( v );
 
-					// Rimuovo il lato i
-					MetaEdge* temp = solution->getEdge( v, i );
-					solution->removeEdge( v, i );
+						// Rimuovo il lato i
+						MetaEdge* temp = solution->getEdge( v, i );
+						solution->removeEdge( v, i );
 
-					diffProfit -= solution->getProfit( v );
+						diffProfit -= solution->getProfit( v );
 
-					// Se non ho differenze di profitto, tolgo quel lato dalla soluzione
-					if( diffProfit == 0 )
-					{
-						// Sposto il nodo di partenza
-						next = temp->getDst( next );
-						// Inserisco il lato tolto nella lista
-						removedEdges.push_back( temp->getEdge() );
-					}
-					else
-					{
-						// Altrimenti lo riaggiungo
-						solution->addEdge( temp->getEdge(), v, i );
-						//temp->setServer( tempVehicle );
-						break;
-					}
+						// Se non ho differenze di profitto, tolgo quel lato dalla soluzione
+						if( diffProfit == 0 )
+						{
+							// Sposto il nodo di partenza
+							next = temp->getDst( next );
+							// Inserisco il lato tolto nella lista
+							removedEdges.push_back( temp->getEdge() );
+						}
+						else
+						{
+							// Altrimenti lo riaggiungo
+							solution->addEdge( temp->getEdge(), v, i );
+							//temp->setServer( tempVehicle );
+							break;
+						}
 
-				}
+					}
 
 #ifdef DEBUG
-				cerr << "Creato un buco di " << removedEdges.size() << " lati su ( " << previous << " " << next << " ) " << endl;
-				cerr << "Cristo: " << solution->toString() << endl;
+					cerr << "Creato un buco di " << removedEdges.size() << " lati su ( " << previous << " " << next << " ) " << endl;
+					cerr << "Cristo: " << solution->toString() << endl;
 #endif
 
-				// Chiedo a Dijkstra di calcolarmi la chiusura migliore
-				list<Edge*> closure = closeSolutionDijkstra( *solution, v, previous, next, i );
-				previous = next;
+					// Chiedo a Dijkstra di calcolarmi la chiusura migliore
+					list<Edge*> closure = closeSolutionDijkstra( *solution, v, previous, next, i );
+					previous = next;
 
-				if ( !closure.size() )
-				{
-					// Quell'incapace del Sig. Bellman-Ford-Zucchelli ha fallito: ripristino.
-					for( auto it = removedEdges.rbegin(); it != removedEdges.rend(); ++it )
-						solution->addEdge( *it, v, i );
+					if ( !closure.size() )
+					{
+						// Quell'incapace del Sig. Bellman-Ford-Zucchelli ha fallito: ripristino.
+						for( auto it = removedEdges.rbegin(); it != removedEdges.rend(); ++it )
+							solution->addEdge( *it, v, i );
 
-					i += removedEdges.size() - 1;
-					continue;
-				}
+						i += removedEdges.size() - 1;
+						continue;
+					}
 
-				// Se questo porta un miglioramento, effettuo la chiusura, altrimenti riaggiungo il lato i
-				for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
-					solution->addEdge( *it, v, i );
+					// Se questo porta un miglioramento, effettuo la chiusura, altrimenti riaggiungo il lato i
+					for ( auto it = closure.rbegin(); it != closure.rend(); ++it )
+						solution->addEdge( *it, v, i );
 
 #ifdef DEBUG
-				cerr << "Soluzioni dopo ricerca locale: " << solution->toString() << endl;
+					cerr << "Soluzioni dopo ricerca locale: " << solution->toString() << endl;
 #endif
 
-				// Do per scontato che Bellman mi dia, nel caso peggiore, una soluzione identica
-				i += closure.size() - 1;
+					// Il tratto chiuso ed i suoi vicini vanno riguardati solo se la chiusura ha migliorato il veicolo
+					bool better = solution->getProfit( v ) > profit ||
+								  ( solution->getProfit( v ) == profit && solution->getCost( v ) < cost );
+					look.erase( look.begin() + i, look.begin() + i + removedEdges.size() );
+					look.insert( look.begin() + i, closure.size(), better );
+					if ( better )
+					{
+						improved = true;
+						if ( i > 0 )
+							look[ i - 1 ] = true;
+						if ( i + closure.size() < look.size() )
+							look[ i + closure.size() ] = true;
+
+						if ( parameters.firstImprovement )
+							break;
+					}
+
+					// Do per scontato che Bellman mi dia, nel caso peggiore, una soluzione identica
+					i += closure.size() - 1;
+				}
 			}
 		}
 		else
@@ -1883,6 +3980,10 @@ void Solver::optimizeSolution( Solution* solution )
 		}
 	}
 
+	// Le chiusure possono aver liberato tempo o capacità per qualche lato ancora libero
+	if ( parameters.insertion )
+		insertProfitable( solution, 0 );
+
 	for ( int i = 0; i < M; i++ )
 		if ( !isFeasible( solution, i ) )
 		{
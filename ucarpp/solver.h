@@ -9,12 +9,18 @@
 #ifndef __ucarpp__solver__
 #define __ucarpp__solver__
 
-//#include <unordered_set>
+#include <unordered_set>
+#include <unordered_map>
+#include <deque>
+#include <queue>
 #include <list>
 #include <vector>
 #include <sstream>
 #include <cmath>
+#include <cfloat>
+#include <thread>
 
+#include <iostream>
 #include <fstream>
 #include <string>
 
@@ -23,36 +29,146 @@
 #include "graph.h"
 #include "meta.h"
 #include "solution.h"
+#include "parameters.h"
+#include "bound.h"
+#include "exact.h"
+#include "acceptance.h"
+#include "elite.h"
+#include "route.h"
+#include "pool.h"
+#include "insertion.h"
 
 namespace solver
 {
 	class Solver
 	{
 		private:
-			const int	N_ITER		= 200;
-			const int	K_MAX		= 10;
-			const float	XI			= 4;
-			const float	P_CLOSE		= .25;
-			const float	P_ACCEPT	= .95;
 			const std::string OUTPUT_FILE_DIR = "../progressive_output/";
 			const std::string OUTPUT_FILE_EXTENSION = ".morz";
 
+			// Operatori della ALNS e punteggi assegnati ( nuovo ottimo, miglioramento, accettazione )
+			static const int ALNS_DESTROYS = 4;
+			static const int ALNS_REPAIRS = 3;
+			static const int ALNS_SCORE_BEST = 33;
+			static const int ALNS_SCORE_BETTER = 9;
+			static const int ALNS_SCORE_ACCEPTED = 13;
+			// Lati condivisi oltre i quali la mrBeanBeanBinPacking si ferma al best fit decreasing
+			static const int PACKING_EXACT_EDGES = 10;
+			// Lati provati dalle chiusure generate una alla volta prima di arrendersi, e lunghezza
+			//  massima di una chiusura di primo miglioramento
+			static const int CLOSURE_BUDGET = 2000;
+			static const int FIRST_CLOSURE_EDGES = 3;
+
+			// Buco lasciato da un operatore di distruzione:
+			//  mancano i lati da src a dst, da inserire prima dell'indice index del veicolo
+			struct Hole
+			{
+				uint vehicle;
+				int index;
+				uint src,
+					 dst;
+			};
+
+			// Chiusure di un buco da src a dst lunghe al più k lati, enumerate in profondità una alla volta.
+			//  Ogni chiusura restituita da next è inserita nella soluzione, che torna com'era alla
+			//  successiva o alla distruzione del generatore: la memoria resta O( k ) e chi consuma
+			//  le chiusure ( estrazione casuale, primo miglioramento, budget ) può fermarsi quando vuole.
+			class Closures
+			{
+				private:
+					struct Frame
+					{
+						uint node;
+						std::vector<model::Edge*> candidates;
+						int next;
+					};
+
+					const Solver* solver;
+					Solution* solution;
+					int vehicle,
+						edgeIndex;
+					uint dst;
+					int k;
+
+					std::vector<Frame> stack;
+					// Lati della chiusura corrente e tempo del veicolo dopo ognuno di essi
+					std::vector<model::Edge*> path;
+					std::vector<uint> time;
+					// Con src == dst la prima chiusura è quella vuota
+					bool empty;
+					long expanded;
+
+				public:
+					Closures( const Solver*, Solution*, int, uint, uint, int, int );
+					~Closures();
+
+					bool next();
+
+					const std::vector<model::Edge*>& getPath() const;
+					long getExpanded() const;
+			};
+
+			// Parametri della ricerca ( N_ITER, K_MAX, XI, P_CLOSE, P_ACCEPT, sigmoide )
+			Parameters parameters;
+
 			model::Graph graph;
 			uint depot,
 			M,
 			Q,
 			tMax;
+			// Limite superiore al profitto, per misurare il gap della soluzione migliore
+			Bound bound;
+			// Soluzioni buone e diverse incontrate dalle ricerche, ricombinate dal path relinking
+			ElitePool elite;
+			// Percorsi incontrati da VNS e VND, ricombinati con un set packing
+			RoutePool pool;
+			// Impronte delle soluzioni già cercate da VNS e VND, al più VISITED: esce la più vecchia
+			std::unordered_set<fingerprint> visited;
+			std::deque<fingerprint> visitedOrder;
+			long visitedLookups,
+				 visitedHits;
+			// Lati uscenti da ogni nodo nell'ordine della costruzione greedy: quelli con domanda
+			//  per rapporto profitto / domanda decrescente, tutti quanti per costo decrescente
+			std::vector< std::vector<model::Edge*> > greedyByRatio;
+			std::vector< std::vector<model::Edge*> > greedyByCost;
 			Solution currentSolution;
 			std::ofstream output_file;
 			
 			Solution createBaseSolution();
 			void createBaseSolution( Solution*, int );
-			int extendBaseSolution( Solution*, int, bool*, int* );
+			Solution createSavingsSolution();
+			// Stato della costruzione greedy: lati già percorsi e, per ogni veicolo,
+			//  ultimo nodo, tempo e carico accumulati e se è ormai pieno.
+			//  Con alpha > 0 il lato viene estratto dalla lista ristretta dei candidati.
+			struct GreedyState
+			{
+				float alpha;
+				uint seed;
+				std::vector<bool> taken;
+				std::vector<uint> last,
+								  time,
+								  load;
+				std::vector<bool> filled;
+			};
+			void sortGreedyCandidates();
+			Solution createGreedySolution( float, uint );
+			model::Edge* pickGreedyEdge( GreedyState*, uint ) const;
+			bool extendBaseSolution( Solution*, GreedyState*, uint );
 			Solution vns( int, Solution );
 			Solution vnd( int, Solution );
 			Solution vnasd( int, Solution, int );
 			Solution vnaasd( int, Solution, int );
 			Solution justBellman();
+			Solution exact( Solution );
+			Solution tabuSearch( int, Solution );
+			Solution alns( int, Solution );
+			Solution memetic( int, Solution );
+			Solution grasp( int, Solution );
+			Solution pathRelinking( Solution );
+			Solution relink( const Solution&, const Solution& );
+			Solution recombineRoutes( Solution );
+			// Aggiunge o toglie un lato profittevole, come passo del path relinking
+			bool relinkMove( Solution*, model::Edge*, bool );
 
 			// Metodi usati per modificare progressivamente la soluzione
 			// Metodo che sceglie come mutare la soluzione, decidendo se ampliandola o restringendola. Ritorna la lunghezza della nuova soluzione modificata.
@@ -61,13 +177,49 @@ namespace solver
 			bool mutateSolutionClose( Solution*, uint, int = -1 );
 			// La soluzione viene ampliata, inserendo un nuovo lato in quello indicato.
 			bool mutateSolutionOpen( Solution*, uint, int = -1 );
+			// Il servizio di un lato viene ceduto ad un altro veicolo che lo attraversa.
+			bool swapServer( Solution*, uint );
+			// Mossa casuale della tabu search: apertura, chiusura o scambio di servente.
+			bool tabuMove( Solution*, uint );
 
 			// Creo un buco nella soluzione di più lati adiacenti. Usato solo nella vnd.
 			int openSolutionRandom( Solution*, uint, int, uint*, uint* );
-			// Metodo inefficiente perchè potenzialmente esplosivo a causa del numero di chiusure possibili.
+			// Chiusura casuale tra quelle lunghe al più k lati, estratta mentre vengono generate.
 			bool closeSolutionRandom( Solution*, int, uint, uint, int, int );
+			// Prima chiusura, tra quelle lunghe al più k lati, che rende la soluzione migliore di quella data.
+			std::list<model::Edge*> closeSolutionFirst( Solution*, int, uint, uint, int, int, const Solution& );
 			std::list<model::Edge*> closeSolutionDijkstra( Solution, int, uint, uint, int );
 
+			// Operatori della ALNS: ogni distruzione lascia al più un buco per veicolo, che la riparazione chiude.
+			bool destroySolution( Solution*, int, int, std::vector<Hole>* );
+			bool repairSolution( Solution*, int, const std::vector<Hole>& );
+			bool closeHole( Solution*, const Hole&, bool );
+			// Rimuove un tratto di lati consecutivi, fermandosi al primo non rimovibile.
+			int removeSegment( Solution*, uint, int, int, std::vector<Hole>* );
+			// Inserisce i lati profittevoli non serviti, in modo greedy o secondo il rimpianto-k.
+			void insertProfitable( Solution*, int );
+			void insertProfitable( Solution*, int, const std::vector<model::Edge*>& );
+			bool insertEdge( Solution*, uint, int, uint, uint, model::Edge*, uint );
+			// Mosse tra veicoli sui lati serviti: spostamento, scambio e scambio delle code, valutate in O( 1 ).
+			bool interRouteSearch( Solution* );
+			bool commitRoutes( Solution*, std::vector<Route>*, uint, const Route&, uint, const Route& );
+			// Mosse interne ad un veicolo: 2-opt ( inversione di un tratto ) ed Or-opt ( spostamento di 1-3 servizi ).
+			bool intraRouteSearch( Solution*, uint );
+			bool commitRoute( Solution*, uint, const Route& );
+			// Versi ottimi dei servizi di ogni veicolo, a parità di ordine.
+			bool orientServices( Solution* );
+			// Giro gigante dei lati profittevoli ( indici in bound.getEdges() ): decodifica, codifica, incrocio.
+			Solution splitTour( const std::vector<int>& );
+			std::vector<int> encodeTour( const Solution&, const std::vector<int>& ) const;
+			std::vector<int> crossTours( const std::vector<int>&, const std::vector<int>& ) const;
+			// Decodifica ed ottimizza i giri in parallelo.
+			std::vector<Solution*> evaluateTours( const std::vector< std::vector<int> >& );
+			// Lati candidati uscenti da un nodo, compreso quello che porta a destinazione.
+			std::vector<model::Edge*> getCandidates( uint, uint ) const;
+			// Sequenza dei nodi visitati dal veicolo, a partire dal deposito.
+			std::vector<uint> getVertices( const Solution*, uint ) const;
+			int roulette( const std::vector<float>& ) const;
+
 			// Metodo basato sul concetto della Bin Packing, usato per cercare una prima ottimizzazione della soluzione.
 			// Il metodo può essere richiamato anche più volte in ogni ciclo di risoluzione.
 			int mrBeanBeanBinPacking( Solution*, int );
@@ -77,12 +229,20 @@ namespace solver
 			void optimizeSolution( Solution* );
 
 			bool isFeasible( const Solution*, int ) const;
+			// Vero se la soluzione è già stata cercata, altrimenti la ricorda
+			bool markVisited( const Solution& );
+			void reportVisited() const;
 			bool isRemovable( const Solution*, int, int ) const;
 
 			void printToFile( Solution* );
 
+			// Stampa il gap della soluzione dal limite superiore
+			void reportGap( const Solution* ) const;
+			// Vero se la soluzione non può migliorare oltre la soglia GAP
+			bool isGapClosed( const Solution* ) const;
+
 		public:
-			Solver( model::Graph, uint, uint, uint, uint );
+			Solver( model::Graph, uint, uint, uint, uint, Parameters = Parameters() );
 			
 			Solution solve( std::string, int );
 
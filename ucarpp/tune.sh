@@ -0,0 +1,126 @@
+#!/bin/bash
+
+# Taratura automatica dei parametri della ricerca, in stile racing (irace).
+#  - Genera CONFIGS configurazioni casuali (la prima è quella di default).
+#  - Valuta in parallelo tutte le configurazioni ancora in gara su un'istanza alla volta.
+#  - Il punteggio di una configurazione su un'istanza è il profitto per secondo di CPU,
+#    normalizzato rispetto alla migliore configurazione sulla stessa istanza.
+#  - Dopo FIRST_TEST istanze, elimina le configurazioni con punteggio medio inferiore
+#    a quello della migliore di oltre MARGIN.
+#
+# Uso: ./tune.sh [metodo] [configurazioni] [job paralleli] [istanze massime]
+
+cd `dirname $0`;
+
+# Percorsi utili
+INSTANCE_PATH="../instances&Results/instances/";
+TUNE_PATH="../instances&Results/tune/";
+EXE="./ucarpp_tune";
+
+METHOD=${1:-VNS};
+CONFIGS=${2:-16};
+JOBS=${3:-`nproc`};
+MAX_STEPS=${4:-60};
+FIRST_TEST=3;
+MARGIN=0.1;
+VEHICLES=(2 3 4);
+TYPES=("ORG" "MDF");
+
+# Compilo il programma
+make || exit 1;
+mv ucarpp $EXE;
+
+rm -rf $TUNE_PATH;
+mkdir -p $TUNE_PATH;
+
+# Genero le configurazioni: una per riga, nella forma NOME=valore ...
+awk -v n=$CONFIGS -v seed=$RANDOM 'BEGIN {
+	srand( seed );
+	split( "ATAN TANH ERF ALG", sigmoids, " " );
+	print "";
+	for ( i = 1; i < n; i++ )
+		printf "N_ITER=%d K_MAX=%d XI=%.2f P_CLOSE=%.2f P_ACCEPT=%.2f SIGMOID=%s SIGMOID_CENTER=%.2f\n",
+			50 + int( rand() * 351 ), 2 + int( rand() * 19 ), 1 + rand() * 7,
+			.05 + rand() * .45, .8 + rand() * .2, sigmoids[ 1 + int( rand() * 4 ) ], .5 + rand() * .4;
+}' > $TUNE_PATH"configs";
+
+mapfile -t PARAMS < $TUNE_PATH"configs";
+ALIVE=(`seq 0 $((${#PARAMS[@]}-1))`);
+for c in ${ALIVE[@]}
+do
+	SCORE[$c]=0;
+done;
+
+# Ordine casuale di istanze, veicoli e tipo: ogni terna è un passo della gara
+STEPS=(`for i in \`ls $INSTANCE_PATH | grep val\`; do for j in ${VEHICLES[@]}; do for t in ${TYPES[@]}; do echo "$i:$j:$t"; done; done; done | shuf | head -n $MAX_STEPS`);
+
+# Esegue una configurazione su un'istanza, salvando profitto e secondi di CPU
+function run {
+	TIMEFORMAT="%U %S";
+	{ time $EXE $INSTANCE_PATH$2 $3 $METHOD $4 ${PARAMS[$1]} > $5.out 2> /dev/null; } 2> $5.time;
+	PROFIT=`sed -n 's/Total Profit: \([0-9][0-9]*\).*/\1/p' $5.out`;
+	echo "${PROFIT:-0} `awk '{ print $1 + $2 }' $5.time`" > $5;
+	rm -f $5.out $5.time;
+}
+
+STEP=0;
+for s in ${STEPS[@]}
+do
+	IFS=":" read INSTANCE M TYPE <<< "$s";
+	STEP=$(($STEP+1));
+	echo "Passo $STEP: $INSTANCE $M $TYPE, ${#ALIVE[@]} configurazioni in gara.";
+
+	# Lancio in parallelo le configurazioni ancora in gara
+	for c in ${ALIVE[@]}
+	do
+		while [ `jobs -r | wc -l` -ge $JOBS ];
+		do
+			wait -n;
+		done;
+		run $c $INSTANCE $M $TYPE $TUNE_PATH"$STEP.$c" &
+	done;
+	wait;
+
+	# Normalizzo il profitto per secondo di CPU rispetto al migliore del passo
+	BEST=`for c in ${ALIVE[@]}; do cat $TUNE_PATH"$STEP.$c"; done | awk 'BEGIN { m = 0 } { r = $1 / ( $2 > .01 ? $2 : .01 ); if ( r > m ) m = r } END { print m }'`;
+	for c in ${ALIVE[@]}
+	do
+		SCORE[$c]=`awk -v s=${SCORE[$c]} -v b=$BEST '{ r = $1 / ( $2 > .01 ? $2 : .01 ); print s + ( b > 0 ? r / b : 0 ) }' $TUNE_PATH"$STEP.$c"`;
+	done;
+
+	# Corsa: elimino le configurazioni staccate dalla migliore
+	if [ $STEP -ge $FIRST_TEST ]
+	then
+		TOP=`for c in ${ALIVE[@]}; do echo ${SCORE[$c]}; done | sort -g | tail -n 1`;
+		SURVIVORS=();
+		for c in ${ALIVE[@]}
+		do
+			if awk -v s=${SCORE[$c]} -v t=$TOP -v n=$STEP -v m=$MARGIN 'BEGIN { exit !( ( t - s ) / n <= m ) }'
+			then
+				SURVIVORS+=($c);
+			else
+				echo "  Eliminata $c: ${PARAMS[$c]:-default}";
+			fi;
+		done;
+		ALIVE=(${SURVIVORS[@]});
+	fi;
+
+	if [ ${#ALIVE[@]} -le 1 ]
+	then
+		break;
+	fi;
+done;
+
+# Classifica finale delle configurazioni sopravvissute
+echo -e "\r\nClassifica ( punteggio medio su $STEP passi ):";
+for c in ${ALIVE[@]}
+do
+	echo "`awk -v s=${SCORE[$c]} -v n=$STEP 'BEGIN { printf "%.3f", s / n }'`	$c	${PARAMS[$c]:-default}";
+done | sort -g -r | tee $TUNE_PATH"ranking";
+
+# Salvo la migliore come file di configurazione, utilizzabile con CONFIG=file
+BEST_CONFIG=`head -n 1 $TUNE_PATH"ranking" | cut -f 2`;
+echo ${PARAMS[$BEST_CONFIG]} | tr ' ' '\n' > $TUNE_PATH"best.conf";
+echo "Configurazione migliore salvata in $TUNE_PATH""best.conf";
+
+rm -f $EXE;
@@ -19,11 +19,26 @@ using namespace model;
 
 /*** Vehicle ***/
 
-Vehicle::Vehicle( int _id ): id( _id )
+/**
+ * Costruttore.
+ *
+ * @param _id	l'identificativo del veicolo
+ * @param edges	il numero di lati del grafo, per gli insiemi di lati percorsi e serviti
+ */
+Vehicle::Vehicle( int _id, uint edges ): id( _id ), hash( getLinkKey( NULL, NULL ) ),
+	traversed( edges ), passages( edges, 0 ), served( edges ), demand( 0 ), profit( 0 )
 {
 	path = list<MetaEdge*>();
 }
 
+/**
+ * Chiave della coppia di lati consecutivi, NULL indica il deposito.
+ */
+fingerprint Vehicle::getLinkKey( const MetaEdge* from, const MetaEdge* to ) const
+{
+	return MetaEdge::getLinkKey( id, ( from ? from->getEdge()->getId() + 1 : 0 ), ( to ? to->getEdge()->getId() + 1 : 0 ) );
+}
+
 //Vehicle::Vehicle( const Vehicle& source ): id( source.id )
 //{
 //	path = source.path;
@@ -48,7 +63,17 @@ void Vehicle::addEdge( MetaEdge* edge, long index )
 		if( **i == *edge )
 			occurence++;
 
+	uint edgeId = edge->getEdge()->getId();
+	passages[ edgeId ]++;
+	traversed.set( edgeId );
+
 	edge->setTaken( this, occurence );
+	hash += MetaEdge::getKey( id, edgeId, false );
+
+	// Il nuovo lato si mette tra il precedente ed il successivo
+	MetaEdge* before = ( it == path.begin() ? NULL : *prev( it ) );
+	MetaEdge* after = ( it == path.end() ? NULL : *it );
+	hash += getLinkKey( before, edge ) + getLinkKey( edge, after ) - getLinkKey( before, after );
 	
 	if ( index == - 1 || index == path.size() )
 		path.push_back( edge );
@@ -69,7 +94,17 @@ void Vehicle::removeEdge( long index )
 		if ( **i == **it )
 			occurrence++;
 	
+	uint edgeId = (*it)->getEdge()->getId();
+	if ( --passages[ edgeId ] == 0 )
+		traversed.reset( edgeId );
+
 	(*it)->unsetTaken( this, occurrence );
+	hash -= MetaEdge::getKey( id, edgeId, false );
+
+	MetaEdge* before = ( it == path.begin() ? NULL : *prev( it ) );
+	MetaEdge* after = ( next( it ) == path.end() ? NULL : *next( it ) );
+	hash += getLinkKey( before, after ) - getLinkKey( before, *it ) - getLinkKey( *it, after );
+
 	path.erase( it );
 }
 
@@ -87,40 +122,70 @@ uint Vehicle::getCost() const
 	return result;
 }
 
+/**
+ * @return	la domanda dei lati serviti, mantenuta ad ogni cambio di servente
+ */
 uint Vehicle::getDemand() const
 {
-	uint result = 0;
-	for ( auto it = path.begin(); it != path.end(); it++ )
-	{
-		auto jt = path.begin();
-		while ( **(jt++) != **it );
-		jt--;
-		
-		result += (*it)->getDemand() * ( (*it)->isServer( this ) && jt == it );
-	}
-	
-	return result;
+	return demand;
 }
 
+/**
+ * @return	il profitto dei lati serviti, mantenuto ad ogni cambio di servente
+ */
 uint Vehicle::getProfit() const
 {
-	uint result = 0;
-	for ( auto it = path.begin(); it != path.end(); it++ )
+	return profit;
+}
+
+/**
+ * Segna un lato richiesto come servito o non più servito dal veicolo.
+ * Chiamato dal metalato quando cambia il primo dei passanti.
+ *
+ * @param edge		il lato
+ * @param isServed	vero, se il veicolo è diventato il servente
+ */
+void Vehicle::setServed( const MetaEdge* edge, bool isServed ) const
+{
+	uint edgeId = edge->getEdge()->getId();
+	if ( served.test( edgeId ) == isServed )
+		return;
+
+	served.set( edgeId, isServed );
+	if ( isServed )
 	{
-		auto jt = path.begin();
-		while ( **(jt++) != **it );
-		jt--;
-		
-//#ifdef DEBUG
-//		cerr << "Lato: " << (*it)->getSrc() << " " << (*it)->getDst() << endl;
-//		cerr << "Profitto: " << (*it)->getProfit() << endl;
-//		cerr << "Servente: " << (*it)->isServer( this ) << endl;
-//		cerr << "Uguale: " << ( ( jt == it ) ? "vero" : "falso" ) << endl;
-//#endif
-		result += (*it)->getProfit() * ( (*it)->isServer( this ) && jt == it );
+		demand += edge->getDemand();
+		profit += edge->getProfit();
 	}
-	
-	return result;
+	else
+	{
+		demand -= edge->getDemand();
+		profit -= edge->getProfit();
+	}
+}
+
+/**
+ * @return	i lati percorsi almeno una volta
+ */
+const boost::dynamic_bitset<>& Vehicle::getTraversed() const
+{
+	return traversed;
+}
+
+/**
+ * @return	i lati richiesti serviti
+ */
+const boost::dynamic_bitset<>& Vehicle::getServed() const
+{
+	return served;
+}
+
+/**
+ * @return	il numero di volte in cui il veicolo percorre il lato
+ */
+uint Vehicle::getPassages( const MetaEdge* edge ) const
+{
+	return passages[ edge->getEdge()->getId() ];
 }
 
 // true se la direzione di percorrenza è da src a dst, false altrimenti
@@ -239,6 +304,12 @@ int Vehicle::getId() const
 	return id;
 }
 
+// Ritorna l'impronta del percorso: lati percorsi e coppie consecutive, quindi sensibile all'ordine
+fingerprint Vehicle::getHash() const
+{
+	return hash;
+}
+
 /**
  * Comparatore di uguaglianza tra veicoli
  */
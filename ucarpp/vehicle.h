@@ -12,6 +12,7 @@
 #include <list>
 #include <vector>
 #include <sstream>
+#include <boost/dynamic_bitset.hpp>
 
 #include "headings.h"
 #include "edge.h"
@@ -22,14 +23,29 @@ namespace solver
 {
 	class Vehicle
 	{
+		friend class MetaEdge;
+
 		private:
 			int id;
 			std::list<MetaEdge*> path;
+			// Somma delle chiavi di Zobrist dei lati percorsi e delle coppie di lati consecutivi
+			fingerprint hash;
+			// Lati percorsi ( con il numero di passaggi ) e lati richiesti serviti, indicizzati con Edge::getId.
+			//  I serviti cambiano anche quando un altro veicolo prende o lascia il lato: li aggiorna il metalato,
+			//  insieme a domanda e profitto serviti.
+			boost::dynamic_bitset<> traversed;
+			std::vector<uint> passages;
+			mutable boost::dynamic_bitset<> served;
+			mutable uint demand,
+						 profit;
+
+			fingerprint getLinkKey( const MetaEdge*, const MetaEdge* ) const;
+			void setServed( const MetaEdge*, bool ) const;
 
 			bool equals( const Vehicle& ) const;
 
 		public:
-			Vehicle( int );
+			Vehicle( int, uint );
 			//Vehicle( const Vehicle& );
 			//~Vehicle();
 			
@@ -43,6 +59,11 @@ namespace solver
 			uint getDemand() const;
 			uint getProfit() const;
 			int getId() const;
+			fingerprint getHash() const;
+
+			const boost::dynamic_bitset<>& getTraversed() const;
+			const boost::dynamic_bitset<>& getServed() const;
+			uint getPassages( const MetaEdge* ) const;
 
 			bool getDirection( int ) const;
 